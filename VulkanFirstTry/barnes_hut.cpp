@@ -0,0 +1,231 @@
+#include "barnes_hut.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace lve {
+
+    void BarnesHutTree::build(
+        const float* x,
+        const float* y,
+        const float* z,
+        const float* mass,
+        const float* radius,
+        size_t count) {
+        nodes.clear();
+        bodyIds.resize(count);
+        if (count == 0) {
+            bodyX.clear();
+            bodyY.clear();
+            bodyZ.clear();
+            bodyMass.clear();
+            bodyRadius.clear();
+            return;
+        }
+
+        float minX = x[0], minY = y[0], minZ = z[0];
+        float maxX = x[0], maxY = y[0], maxZ = z[0];
+        for (size_t i = 0; i < count; i++) {
+            minX = std::min(minX, x[i]);
+            minY = std::min(minY, y[i]);
+            minZ = std::min(minZ, z[i]);
+            maxX = std::max(maxX, x[i]);
+            maxY = std::max(maxY, y[i]);
+            maxZ = std::max(maxZ, z[i]);
+            bodyIds[i] = static_cast<uint32_t>(i);
+        }
+
+        Node root{};
+        root.centerX = 0.5f * (minX + maxX);
+        root.centerY = 0.5f * (minY + maxY);
+        root.centerZ = 0.5f * (minZ + maxZ);
+        // pad the cube slightly so bodies on the max faces still fall inside
+        root.halfSize = 0.5f * std::max({ maxX - minX, maxY - minY, maxZ - minZ }) * 1.001f + 1e-6f;
+        root.firstBody = 0;
+        root.bodyCount = static_cast<uint32_t>(count);
+        nodes.reserve(2 * count / LEAF_CAPACITY + 1);
+        nodes.push_back(root);
+
+        inX = x;
+        inY = y;
+        inZ = z;
+        scratch.resize(count);
+        buildNode(0, 0);
+        inX = inY = inZ = nullptr;
+
+        // copy the bodies into tree order so leaf walks read contiguous memory
+        bodyX.resize(count);
+        bodyY.resize(count);
+        bodyZ.resize(count);
+        bodyMass.resize(count);
+        bodyRadius.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            const uint32_t id = bodyIds[k];
+            bodyX[k] = x[id];
+            bodyY[k] = y[id];
+            bodyZ[k] = z[id];
+            bodyMass[k] = mass[id];
+            bodyRadius[k] = radius[id];
+        }
+
+        // leaves and then interior nodes get their mass moments bottom-up; children always have a
+        // larger index than their parent, so a reverse sweep visits them first
+        for (size_t n = nodes.size(); n-- > 0;) {
+            Node& node = nodes[n];
+            float m = 0.0f, mx = 0.0f, my = 0.0f, mz = 0.0f;
+            if (node.childCount == 0) {
+                for (uint32_t k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+                    m += bodyMass[k];
+                    mx += bodyMass[k] * bodyX[k];
+                    my += bodyMass[k] * bodyY[k];
+                    mz += bodyMass[k] * bodyZ[k];
+                }
+            }
+            else {
+                for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                    const Node& child = nodes[c];
+                    m += child.mass;
+                    mx += child.mass * child.comX;
+                    my += child.mass * child.comY;
+                    mz += child.mass * child.comZ;
+                }
+            }
+            node.mass = m;
+            if (m > 0.0f) {
+                node.comX = mx / m;
+                node.comY = my / m;
+                node.comZ = mz / m;
+            }
+            else {
+                node.comX = node.centerX;
+                node.comY = node.centerY;
+                node.comZ = node.centerZ;
+            }
+        }
+    }
+
+    int BarnesHutTree::octantOf(const Node& node, uint32_t body) const {
+        return (inX[body] >= node.centerX ? 1 : 0) | (inY[body] >= node.centerY ? 2 : 0) |
+            (inZ[body] >= node.centerZ ? 4 : 0);
+    }
+
+    void BarnesHutTree::buildNode(uint32_t nodeIndex, int depth) {
+        const Node node = nodes[nodeIndex];
+        if (node.bodyCount <= LEAF_CAPACITY || depth >= MAX_DEPTH) {
+            nodes[nodeIndex].childCount = 0;
+            return;
+        }
+
+        // counting sort of the node's body range by octant
+        std::array<uint32_t, 8> counts{};
+        for (uint32_t k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+            counts[octantOf(node, bodyIds[k])]++;
+        }
+        std::array<uint32_t, 8> offsets{};
+        uint32_t running = node.firstBody;
+        for (int o = 0; o < 8; o++) {
+            offsets[o] = running;
+            running += counts[o];
+        }
+        std::array<uint32_t, 8> cursor = offsets;
+        for (uint32_t k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+            scratch[cursor[octantOf(node, bodyIds[k])]++] = bodyIds[k];
+        }
+        std::copy(
+            scratch.begin() + node.firstBody,
+            scratch.begin() + node.firstBody + node.bodyCount,
+            bodyIds.begin() + node.firstBody);
+
+        // children of a node are stored next to each other, empty octants are skipped
+        const uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+        const float quarter = 0.5f * node.halfSize;
+        uint32_t childCount = 0;
+        for (int o = 0; o < 8; o++) {
+            if (counts[o] == 0) continue;
+            Node child{};
+            child.centerX = node.centerX + ((o & 1) ? quarter : -quarter);
+            child.centerY = node.centerY + ((o & 2) ? quarter : -quarter);
+            child.centerZ = node.centerZ + ((o & 4) ? quarter : -quarter);
+            child.halfSize = quarter;
+            child.firstBody = offsets[o];
+            child.bodyCount = counts[o];
+            nodes.push_back(child);
+            childCount++;
+        }
+        nodes[nodeIndex].firstChild = firstChild;
+        nodes[nodeIndex].childCount = childCount;
+
+        for (uint32_t c = firstChild; c < firstChild + childCount; c++) {
+            buildNode(c, depth + 1);
+        }
+    }
+
+    void BarnesHutTree::accelerationAt(
+        float px, float py, float pz, float radius, uint32_t self, float theta, float out[3]) const {
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        if (nodes.empty()) {
+            out[0] = out[1] = out[2] = 0.0f;
+            return;
+        }
+
+        const float theta2 = theta * theta;
+        // every level pops one node and pushes at most eight
+        std::array<uint32_t, 7 * MAX_DEPTH + 8> stack;
+        size_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+
+            if (node.childCount == 0) {
+                for (uint32_t k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+                    if (bodyIds[k] == self) continue;
+                    const float dx = bodyX[k] - px;
+                    const float dy = bodyY[k] - py;
+                    const float dz = bodyZ[k] - pz;
+                    const float r2 = dx * dx + dy * dy + dz * dz;
+                    const float touch = radius + bodyRadius[k];
+                    if (r2 < touch * touch || r2 == 0.0f) continue;
+                    const float invR = 1.0f / std::sqrt(r2);
+                    const float s = bodyMass[k] * invR * invR * invR;
+                    ax += s * dx;
+                    ay += s * dy;
+                    az += s * dz;
+                }
+                continue;
+            }
+
+            const float dx = node.comX - px;
+            const float dy = node.comY - py;
+            const float dz = node.comZ - pz;
+            const float d2 = dx * dx + dy * dy + dz * dz;
+            const float size = 2.0f * node.halfSize;
+            // never approximate a cell the target sits in, its own mass would pull on it
+            const bool outside = std::fabs(px - node.centerX) > node.halfSize ||
+                std::fabs(py - node.centerY) > node.halfSize ||
+                std::fabs(pz - node.centerZ) > node.halfSize;
+
+            if (outside && size * size < theta2 * d2) {
+                const float invR = 1.0f / std::sqrt(d2);
+                const float s = node.mass * invR * invR * invR;
+                ax += s * dx;
+                ay += s * dy;
+                az += s * dz;
+            }
+            else {
+                assert(top + node.childCount <= stack.size() && "Barnes-Hut traversal stack overflow");
+                for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                    stack[top++] = c;
+                }
+            }
+        }
+
+        out[0] = ax;
+        out[1] = ay;
+        out[2] = az;
+    }
+
+}  // namespace lve
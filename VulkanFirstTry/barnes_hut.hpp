@@ -0,0 +1,70 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+    // Octree over body positions for Barnes-Hut gravity. The tree is rebuilt from scratch every
+    // substep and works in plain (unscaled) simulation units: accelerationAt returns
+    // sum(m * (p_j - p) / |p_j - p|^3), the caller applies the gravity constant and unit scale.
+    class BarnesHutTree {
+    public:
+        static constexpr uint32_t NO_BODY = UINT32_MAX;
+        static constexpr uint32_t LEAF_CAPACITY = 8;
+        static constexpr int MAX_DEPTH = 32;
+
+        struct Node {
+            float centerX, centerY, centerZ;  // geometric center of the cube
+            float halfSize;
+            float comX, comY, comZ;  // center of mass
+            float mass;
+            uint32_t firstChild;
+            uint32_t childCount;  // 0 for leaves
+            uint32_t firstBody;
+            uint32_t bodyCount;
+        };
+
+        BarnesHutTree() = default;
+
+        BarnesHutTree(const BarnesHutTree&) = delete;
+        BarnesHutTree& operator=(const BarnesHutTree&) = delete;
+
+        void build(
+            const float* x,
+            const float* y,
+            const float* z,
+            const float* mass,
+            const float* radius,
+            size_t count);
+
+        // Bodies overlapping the target (distance below the summed radii) are skipped, they are
+        // handled by the collision pass instead. `self` is excluded, pass NO_BODY for field points.
+        void accelerationAt(
+            float px, float py, float pz, float radius, uint32_t self, float theta, float out[3]) const;
+
+        size_t nodeCount() const { return nodes.size(); }
+        size_t bodyCount() const { return bodyIds.size(); }
+
+    private:
+        void buildNode(uint32_t nodeIndex, int depth);
+        int octantOf(const Node& node, uint32_t body) const;
+
+        std::vector<Node> nodes;
+
+        // bodies in tree order, leaves reference contiguous ranges
+        std::vector<float> bodyX;
+        std::vector<float> bodyY;
+        std::vector<float> bodyZ;
+        std::vector<float> bodyMass;
+        std::vector<float> bodyRadius;
+        std::vector<uint32_t> bodyIds;
+        std::vector<uint32_t> scratch;
+
+        // input arrays, only valid during build()
+        const float* inX = nullptr;
+        const float* inY = nullptr;
+        const float* inZ = nullptr;
+    };
+}  // namespace lve
@@ -0,0 +1,203 @@
+#include "body_store.hpp"
+
+// std
+#include <cassert>
+#include <cmath>
+
+namespace lve {
+
+    void BodyStore::reserve(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+        vx.reserve(count);
+        vy.reserve(count);
+        vz.reserve(count);
+        mass.reserve(count);
+        radius.reserve(count);
+        colorR.reserve(count);
+        colorG.reserve(count);
+        colorB.reserve(count);
+        ids.reserve(count);
+        if (doubleState) {
+            xd.reserve(count);
+            yd.reserve(count);
+            zd.reserve(count);
+            vxd.reserve(count);
+            vyd.reserve(count);
+            vzd.reserve(count);
+        }
+    }
+
+    void BodyStore::clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+        vx.clear();
+        vy.clear();
+        vz.clear();
+        mass.clear();
+        radius.clear();
+        colorR.clear();
+        colorG.clear();
+        colorB.clear();
+        ids.clear();
+        xd.clear();
+        yd.clear();
+        zd.clear();
+        vxd.clear();
+        vyd.clear();
+        vzd.clear();
+    }
+
+    void BodyStore::enableDoubleState() {
+        xd.assign(x.begin(), x.end());
+        yd.assign(y.begin(), y.end());
+        zd.assign(z.begin(), z.end());
+        vxd.assign(vx.begin(), vx.end());
+        vyd.assign(vy.begin(), vy.end());
+        vzd.assign(vz.begin(), vz.end());
+        doubleState = true;
+    }
+
+    void BodyStore::disableDoubleState() {
+        syncFloatState();
+        xd.clear();
+        yd.clear();
+        zd.clear();
+        vxd.clear();
+        vyd.clear();
+        vzd.clear();
+        doubleState = false;
+    }
+
+    void BodyStore::syncFloatState() {
+        if (!doubleState) return;
+        for (size_t i = 0; i < size(); i++) {
+            x[i] = static_cast<float>(xd[i]);
+            y[i] = static_cast<float>(yd[i]);
+            z[i] = static_cast<float>(zd[i]);
+            vx[i] = static_cast<float>(vxd[i]);
+            vy[i] = static_cast<float>(vyd[i]);
+            vz[i] = static_cast<float>(vzd[i]);
+        }
+    }
+
+    size_t BodyStore::add(
+        id_t id,
+        float px, float py, float pz,
+        float velX, float velY, float velZ,
+        float bodyMass,
+        float bodyRadius,
+        float r, float g, float b) {
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+        vx.push_back(velX);
+        vy.push_back(velY);
+        vz.push_back(velZ);
+        mass.push_back(bodyMass);
+        radius.push_back(bodyRadius);
+        colorR.push_back(r);
+        colorG.push_back(g);
+        colorB.push_back(b);
+        ids.push_back(id);
+        if (doubleState) {
+            xd.push_back(px);
+            yd.push_back(py);
+            zd.push_back(pz);
+            vxd.push_back(velX);
+            vyd.push_back(velY);
+            vzd.push_back(velZ);
+        }
+        return ids.size() - 1;
+    }
+
+    void BodyStore::merge(size_t a, size_t b) {
+        assert(a != b && a < size() && b < size() && "Invalid merge pair");
+        const float masses = mass[a] + mass[b];
+
+        // the heavier body keeps its position
+        if (mass[b] >= mass[a]) {
+            x[a] = x[b];
+            y[a] = y[b];
+            z[a] = z[b];
+        }
+        vx[a] = (vx[a] * mass[a] + vx[b] * mass[b]) / masses;
+        vy[a] = (vy[a] * mass[a] + vy[b] * mass[b]) / masses;
+        vz[a] = (vz[a] * mass[a] + vz[b] * mass[b]) / masses;
+
+        if (doubleState) {
+            if (mass[b] >= mass[a]) {
+                xd[a] = xd[b];
+                yd[a] = yd[b];
+                zd[a] = zd[b];
+            }
+            const double ma = mass[a], mb = mass[b];
+            vxd[a] = (vxd[a] * ma + vxd[b] * mb) / (ma + mb);
+            vyd[a] = (vyd[a] * ma + vyd[b] * mb) / (ma + mb);
+            vzd[a] = (vzd[a] * ma + vzd[b] * mb) / (ma + mb);
+        }
+
+        const float t = mass[b] / masses;
+        colorR[a] += (colorR[b] - colorR[a]) * t;
+        colorG[a] += (colorG[b] - colorG[a]) * t;
+        colorB[a] += (colorB[b] - colorB[a]) * t;
+
+        // keeps the summed disc area
+        radius[a] = std::sqrt(radius[a] * radius[a] + radius[b] * radius[b]);
+        mass[a] = masses;
+    }
+
+    void BodyStore::compact(const std::vector<uint8_t>& removed) {
+        assert(removed.size() == size() && "One removal flag per body");
+        size_t kept = 0;
+        for (size_t i = 0; i < removed.size(); i++) {
+            if (removed[i]) continue;
+            if (kept != i) {
+                x[kept] = x[i];
+                y[kept] = y[i];
+                z[kept] = z[i];
+                vx[kept] = vx[i];
+                vy[kept] = vy[i];
+                vz[kept] = vz[i];
+                mass[kept] = mass[i];
+                radius[kept] = radius[i];
+                colorR[kept] = colorR[i];
+                colorG[kept] = colorG[i];
+                colorB[kept] = colorB[i];
+                ids[kept] = ids[i];
+                if (doubleState) {
+                    xd[kept] = xd[i];
+                    yd[kept] = yd[i];
+                    zd[kept] = zd[i];
+                    vxd[kept] = vxd[i];
+                    vyd[kept] = vyd[i];
+                    vzd[kept] = vzd[i];
+                }
+            }
+            kept++;
+        }
+        x.resize(kept);
+        y.resize(kept);
+        z.resize(kept);
+        vx.resize(kept);
+        vy.resize(kept);
+        vz.resize(kept);
+        mass.resize(kept);
+        radius.resize(kept);
+        colorR.resize(kept);
+        colorG.resize(kept);
+        colorB.resize(kept);
+        ids.resize(kept);
+        if (doubleState) {
+            xd.resize(kept);
+            yd.resize(kept);
+            zd.resize(kept);
+            vxd.resize(kept);
+            vyd.resize(kept);
+            vzd.resize(kept);
+        }
+    }
+
+}  // namespace lve
\ No newline at end of file
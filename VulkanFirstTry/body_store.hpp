@@ -0,0 +1,57 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+    // Structure-of-arrays state of every simulated body. The physics hot loops only stream the
+    // arrays they need; render objects are synced from here once per frame using `ids`.
+    // Velocities are in physical units (per unitScale), positions and radii in scene units.
+    struct BodyStore {
+        using id_t = uint32_t;
+
+        std::vector<float> x, y, z;
+        std::vector<float> vx, vy, vz;
+        std::vector<float> mass;
+        std::vector<float> radius;
+
+        // only read and written by merges
+        std::vector<float> colorR, colorG, colorB;
+        std::vector<id_t> ids;
+
+        // Optional double precision positions and velocities. While enabled they are the simulation
+        // state, kept in step by add/merge/compact, and the float arrays above are only refreshed by
+        // syncFloatState() for rendering.
+        std::vector<double> xd, yd, zd;
+        std::vector<double> vxd, vyd, vzd;
+
+        size_t size() const { return x.size(); }
+        bool empty() const { return x.empty(); }
+
+        bool hasDoubleState() const { return doubleState; }
+        // copies the float state into the double arrays
+        void enableDoubleState();
+        void disableDoubleState();
+        void syncFloatState();
+
+        void reserve(size_t count);
+        void clear();
+        size_t add(
+            id_t id,
+            float px, float py, float pz,
+            float velX, float velY, float velZ,
+            float bodyMass,
+            float bodyRadius,
+            float r = 1.0f, float g = 1.0f, float b = 1.0f);
+
+        // Momentum-conserving merge of body `b` into body `a`; `b` is left untouched.
+        void merge(size_t a, size_t b);
+        // Drops every body flagged in `removed` in a single pass, keeping the order of the rest.
+        void compact(const std::vector<uint8_t>& removed);
+
+    private:
+        bool doubleState = false;
+    };
+}  // namespace lve
@@ -1,8 +1,16 @@
 #include "first_app.hpp"
+#include "frame_benchmark.hpp"
+#include "gpu_cull_system.hpp"
+#include "gpu_nbody_system.hpp"
+#include "lve_buffer.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_secondary_recorder.hpp"
 #include "simple_render_system.hpp"
 #include "model.hpp"
 #include "lve_camera.hpp"
 #include "keyboard_controller.hpp"
+#include "physics_system.hpp"
+#include "physics_thread.hpp"
 
 //libs
 #define GLM_FORCE_RADIANS
@@ -14,6 +22,7 @@
 
 
 // std
+#include <algorithm>
 #include <array>
 #include <stdexcept>
 #include <math.h>
@@ -21,117 +30,6 @@
 #include <chrono>
 
 namespace lve {
-    class PhysicsSystem {
-    public:
-        PhysicsSystem(float gravity, float scale, LveDevice& device, GLFWwindow* window, std::vector<LveGameObject>& objects) : strengthGravity{ gravity }, unitScale{ scale }, lveDevice{ device }, lveWindow{ window }, gameObjects2{objects}
-        {
-            lve::LveGameObject centerOfMassObj = LveGameObject::createGameObject();
-            centerOfMassObj.color = { 1.f, 1.f, 1.f };
-            centerOfMassObj.model = Model::createCrossModel(lveDevice, centerOfMassObj.color);
-            centerOfMassObj.transform.scale = glm::vec3{ 0.02f };
-            centerOfMassObj.transform.translation.x = -1.f;
-            objects.push_back(std::move(centerOfMassObj));    
-        }
-        const float strengthGravity;
-        const float unitScale;
-		LveDevice& lveDevice;
-		GLFWwindow* lveWindow;
-		std::vector<LveGameObject>& gameObjects2;
-
-
-        void update(std::vector<LveGameObject>& gameObjects, float dt, unsigned int substeps = 1) {
-            const float stepDelta = dt / substeps;
-            for (int i = 0; i < substeps; i++) {
-                stepSimulation(gameObjects, stepDelta);
-            }
-        }
-
-        glm::vec3 computeForce(LveGameObject& obj1, LveGameObject& obj2, std::vector<LveGameObject>& gameObjects, std::vector<LveGameObject>::iterator& iterA, std::vector<LveGameObject>::iterator& iterB) const {
-            auto distance = (obj1.transform.translation - obj2.transform.translation) * unitScale;
-            float distanceSquared = glm::dot(distance, distance);
-			float min = (glm::sqrt(glm::pow(obj1.transform.scale.x, 2) + glm::pow(obj1.transform.scale.y, 2))) * unitScale;
-			float dis2 = obj1.transform.scale.x + obj2.transform.scale.x;
-            float minDis = glm::dot(min, min);
-            //std::cout << distanceSquared << " Obj: " << obj1.color.r << obj1.color.g << obj1.color.b << " obj2: " << obj2.color.r << obj2.color.g << obj2.color.b << std::endl;
-            //if (glm::sqrt(distanceSquared) < glm::sqrt(minDis)) {
-			if (glm::sqrt(distanceSquared) < dis2 * unitScale) {
-                float masses = obj1.rigidBody.mass + obj2.rigidBody.mass;
-                glm::vec3 finalVelocity = (obj1.rigidBody.velocity * obj1.rigidBody.mass + obj2.rigidBody.velocity * obj2.rigidBody.mass) / masses;
-
-				obj1.transform.translation = obj1.rigidBody.mass > obj2.rigidBody.mass ? obj1.transform.translation : obj2.transform.translation;
-                obj1.rigidBody.velocity = finalVelocity;
-                obj1.rigidBody.mass = masses;
-				obj1.color = glm::mix(obj1.color, obj2.color, obj2.rigidBody.mass / masses);
-				//obj1.color = glm::vec3((obj1.color.r + obj2.color.r)/2.0f, (obj1.color.g + obj2.color.g)/2.0f, (obj1.color.b + obj2.color.b)/2.0f);
-                obj1.transform.scale = glm::vec3(glm::sqrt(glm::pow(obj1.transform.scale.x, 2) + glm::pow(obj2.transform.scale.x, 2)));
-                gameObjects.erase(iterB);
-				iterB = iterA;
-				
-				return glm::vec3(0.0f, 0.0f, 0.0f);
-            }
-            float force = strengthGravity * obj1.rigidBody.mass * obj2.rigidBody.mass / distanceSquared;
-            return force * distance / glm::sqrt(distanceSquared);
-        }
-
-    private:
-        glm::vec3 centerOfMass{};
-        glm::vec3 centerOfMassVelocity{};
-        float totalMassStar{};
-        float totalMass{};
-        void stepSimulation(std::vector<LveGameObject>& gameObjects, float dt) {
-            
-            for (auto iterA = gameObjects.begin(); iterA != gameObjects.end(); ++iterA) {
-                auto& objA = *iterA;
-					
-                for (auto iterB = iterA; iterB != gameObjects.end(); ++iterB) {
-                    if (iterA == iterB) continue;
-                    auto& objB = *iterB;
-
-                    auto force = computeForce(objA, objB, gameObjects, iterA, iterB);
-                    //force = glm::vec3(0.0f);
-                    if (force != glm::vec3(0.0f, 0.0f, 0.0f)) {
-                        objA.rigidBody.velocity += dt * -force / objA.rigidBody.mass;
-                        objB.rigidBody.velocity += dt * force / objB.rigidBody.mass;
-                    }
-                    else {
-                        continue;
-					}
-				}
-			}
-            
-            LveGameObject& relativeObj = gameObjects[0];
-            centerOfMass = glm::vec3(0.0f);
-            centerOfMassVelocity = glm::vec3(0.0f);
-            totalMassStar = 0.0f;
-            totalMass = 0.0f;
-            for (auto& obj : gameObjects) {
-				obj.transform.translation += dt * (obj.rigidBody.velocity / unitScale);
-                
-                if (obj.getId() != relativeObj.getId() || gameObjects.size() == 1) {
-                    centerOfMass += obj.rigidBody.mass * obj.transform.translation;
-                    centerOfMassVelocity += obj.rigidBody.mass * (relativeObj.rigidBody.velocity - obj.rigidBody.velocity);
-                    totalMassStar += obj.rigidBody.mass;
-                }
-                totalMass += obj.rigidBody.mass;
-            }
-			centerOfMass /= totalMassStar;
-            centerOfMassVelocity /= totalMassStar;
-			gameObjects2[0].transform.translation = centerOfMass;
-			
-			
-            for (auto& obj : gameObjects) {
-                auto effectiveVelocity = ((totalMass - obj.rigidBody.mass) / totalMass) * centerOfMassVelocity; // km/s
-                //std::cout << effectiveVelocity.x << std::endl;
-                effectiveVelocity *= 1000; //m/s
-                effectiveVelocity *= 10; //augment relativistic effect 
-				
-
-				//Object dilation
-				//obj.transform.scale *= glm::sqrt(1.0f - glm::pow(glm::length(effectiveVelocity) / 299792458.0f, 2));
-            }
-        }
-    };
-
 	/*
     class Vec2FieldSystem {
     public:
@@ -156,10 +54,48 @@ namespace lve {
     
 
 
-    FirstApp::FirstApp() {
+    FirstApp::FirstApp(const FirstAppConfig& config) : config{ config } {
+        globalPool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
         //unit = 384000000.0f + 6371000.0f + 1737000.0f;
         unit = 1.0f;
         loadGameObjects();
+        loadPhysicsBodies();
+    }
+
+    void FirstApp::loadPhysicsBodies() {
+        physicsBodies.clear();
+        physicsBodies.reserve(physicsObjects.size());
+        for (auto& obj : physicsObjects) {
+            physicsBodies.add(
+                obj.getId(),
+                obj.transform.translation.x, obj.transform.translation.y, obj.transform.translation.z,
+                obj.rigidBody.velocity.x, obj.rigidBody.velocity.y, obj.rigidBody.velocity.z,
+                obj.rigidBody.mass,
+                obj.transform.scale.x,
+                obj.color.r, obj.color.g, obj.color.b);
+        }
+    }
+
+    void FirstApp::syncPhysicsObjects(const PhysicsSnapshot& snapshot, float alpha) {
+        // the store keeps the load order, so objects whose body was merged away are simply the ones
+        // the walk does not find next
+        size_t body = 0;
+        auto merged = std::remove_if(physicsObjects.begin(), physicsObjects.end(), [&](LveGameObject& obj) {
+            if (body >= snapshot.ids.size() || snapshot.ids[body] != obj.getId()) {
+                return true;
+            }
+            const glm::vec3 previous{ snapshot.previousX[body], snapshot.previousY[body], snapshot.previousZ[body] };
+            const glm::vec3 current{ snapshot.x[body], snapshot.y[body], snapshot.z[body] };
+            obj.transform.translation = glm::mix(previous, current, alpha);
+            obj.transform.scale = glm::vec3{ snapshot.radius[body] };
+            obj.color = { snapshot.colorR[body], snapshot.colorG[body], snapshot.colorB[body] };
+            body++;
+            return false;
+        });
+        physicsObjects.erase(merged, physicsObjects.end());
     }
 
     void FirstApp::loadGameObjects() {
@@ -169,6 +105,13 @@ namespace lve {
         std::shared_ptr<LveModel> lveModel = std::make_unique<LveModel>(lveDevice, sierpinskiVert);
         */
         circleModel = Model::createCircleModel(lveDevice, 64);
+
+        auto centerOfMassObj = LveGameObject::createGameObject();
+        centerOfMassObj.color = { 1.f, 1.f, 1.f };
+        centerOfMassObj.model = Model::createCrossModel(lveDevice, centerOfMassObj.color);
+        centerOfMassObj.transform.scale = glm::vec3{ 0.02f };
+        centerOfMassObj.transform.translation.x = -1.f;
+        gameObjects.push_back(std::move(centerOfMassObj));
         std::shared_ptr<LveModel> lveRectangle = Model::createRectangleModel(lveDevice, glm::vec3(1.0f, 0.f, 0.f));
 		
         auto obj = LveGameObject::createGameObject();
@@ -318,9 +261,54 @@ namespace lve {
     FirstApp::~FirstApp() {}
 
     void FirstApp::run() {
-        PhysicsSystem gravitySystem{ /* 6.6743e-11f 0.81f */ 1.0f, unit, lveDevice, lveWindow.getGLFWwindow(), gameObjects};
+        PhysicsSystem gravitySystem{ /* 6.6743e-11f 0.81f */ 1.0f, unit };
+        //gravitySystem.solver = GravitySolver::BarnesHut;
+        //gravitySystem.openingAngle = 0.5f;
+        //gravitySystem.forceErrorRegression = true;
+        //gravitySystem.integrator = Integrator::Leapfrog;  // holds energy at 1 substep better than Euler at 5
+        //gravitySystem.precision = Precision::Mixed;  // for the Earth/Moon scale scene
         //Vec2FieldSystem vecFieldSystem{};
-        SimpleRenderSystem simpleRenderSystem{ lveDevice, lveRenderer.getSwapChainRenderPass() };
+        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& uboBuffer : uboBuffers) {
+            uboBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(GlobalUbo),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            uboBuffer->map();
+        }
+
+        auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .build();
+
+        std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (size_t i = 0; i < globalDescriptorSets.size(); i++) {
+            auto bufferInfo = uboBuffers[i]->descriptorInfo();
+            LveDescriptorWriter(*globalSetLayout, *globalPool)
+                .writeBuffer(0, &bufferInfo)
+                .build(globalDescriptorSets[i]);
+        }
+
+        SimpleRenderSystem simpleRenderSystem{
+            lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+        simpleRenderSystem.impostorBodies = config.impostorBodies;
+        GpuCullSystem gpuCullSystem{ lveDevice };
+
+        const bool gpuPhysics = config.gpuPhysics;
+        std::unique_ptr<GpuNbodySystem> gpuNbodySystem;
+        if (gpuPhysics) {
+            gpuNbodySystem = std::make_unique<GpuNbodySystem>(
+                lveDevice, lveRenderer.getSwapChainRenderPass(), gravitySystem.strengthGravity, gravitySystem.unitScale);
+            gpuNbodySystem->upload(physicsBodies);
+        }
+
+        const bool parallelRecording = config.parallelRecording;
+        std::unique_ptr<LveSecondaryRecorder> secondaryRecorder;
+        if (parallelRecording) {
+            secondaryRecorder = std::make_unique<LveSecondaryRecorder>(lveDevice);
+        }
 		LveCamera camera{};
         auto viewerObject = LveGameObject::createGameObject();
 		viewerObject.transform.translation = { 0.0f, 0.0f, -3.0f };
@@ -329,11 +317,31 @@ namespace lve {
         float speedUp = 0.005f;
         glm::vec3 target{};
 
+        // one step per 60th of a second of real time, whatever the frame rate
+        PhysicsThread physicsThread{ gravitySystem, physicsBodies, (1.f / 60) * speedUp, 5, speedUp };
+        if (!gpuPhysics) {
+            physicsThread.start();
+        }
+
+        lveRenderer.setFramesInFlight(config.framesInFlight);
+
+        std::vector<double> benchmarkFrameTimes;
+        benchmarkFrameTimes.reserve(config.benchmarkFrames);
+        uint32_t frameCount = 0;
+
 		auto currentTime = std::chrono::high_resolution_clock::now();
         while (!lveWindow.shouldClose()) {
+            if (config.benchmarkFrames > 0 && benchmarkFrameTimes.size() == config.benchmarkFrames) {
+                break;
+            }
+            // waiting for the GPU here rather than in beginFrame gets the frame the newest input
+            lveRenderer.waitForFrameSlot();
             glfwPollEvents();
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+            if (config.benchmarkFrames > 0 && frameCount++ > BENCHMARK_WARMUP_FRAMES) {
+                benchmarkFrameTimes.push_back(std::chrono::duration<double>(newTime - currentTime).count());
+            }
             currentTime = newTime;
 
             cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
@@ -347,19 +355,80 @@ namespace lve {
 			
 
             if (auto commandBuffer = lveRenderer.beginFrame()) {
-                gravitySystem.update(physicsObjects, (1.f / 60) * speedUp, 5);
-                //vecFieldSystem.update(gravitySystem, physicsObjects, vectorField);
+                int frameIndex = lveRenderer.getFrameIndex();
+                FrameInfo frameInfo{
+                    frameIndex,
+                    frameTime,
+                    commandBuffer,
+                    camera,
+                    globalDescriptorSets[frameIndex] };
+
+                // the fence of this frame has been waited on, nothing reads its ubo anymore
+                GlobalUbo ubo{};
+                ubo.projection = camera.getProjection();
+                ubo.view = camera.getView();
+                ubo.projectionView = ubo.projection * ubo.view;
+                uboBuffers[frameIndex]->writeToBuffer(&ubo);
 
-                lveRenderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRenderSystem.renderGameObjects(commandBuffer, gameObjects, camera);
-                simpleRenderSystem.renderGameObjects(commandBuffer, vectorField, camera);
-                simpleRenderSystem.renderGameObjects(commandBuffer, physicsObjects, camera);
+                std::vector<std::vector<LveGameObject>*> objectLists{ &gameObjects, &vectorField };
+                if (gpuPhysics) {
+                    gpuNbodySystem->update(commandBuffer, (1.f / 60) * speedUp, 5);
+                }
+                else {
+                    // shows the bodies between the last two steps, at most one step behind
+                    physicsThread.pollSnapshot();
+                    const PhysicsSnapshot& snapshot = physicsThread.getSnapshot();
+                    const float alpha = physicsThread.interpolationFactor(snapshot, std::chrono::steady_clock::now());
+                    syncPhysicsObjects(snapshot, alpha);
+                    gameObjects[0].transform.translation = glm::mix(
+                        glm::vec3{ snapshot.previousCenterOfMass[0], snapshot.previousCenterOfMass[1], snapshot.previousCenterOfMass[2] },
+                        glm::vec3{ snapshot.centerOfMass[0], snapshot.centerOfMass[1], snapshot.centerOfMass[2] },
+                        alpha);
+                    //vecFieldSystem.update(gravitySystem, physicsObjects, vectorField);
+                    if (!parallelRecording) {
+                        simpleRenderSystem.selectCircleLods(
+                            camera, static_cast<float>(lveRenderer.getSwapChainExtent().height), physicsObjects);
+                    }
+                    objectLists.push_back(&physicsObjects);
+                }
+
+                if (parallelRecording) {
+                    // the whole subpass comes from secondary command buffers then, so the GPU bodies
+                    // are not drawn
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    simpleRenderSystem.renderGameObjectsParallel(
+                        frameInfo,
+                        objectLists,
+                        *secondaryRecorder,
+                        lveRenderer.getSwapChainRenderPass(),
+                        lveRenderer.getCurrentFramebuffer(),
+                        lveRenderer.getSwapChainExtent());
+                }
+                else {
+                    gpuCullSystem.cull(commandBuffer, frameIndex, objectLists, camera);
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    simpleRenderSystem.renderCulledGameObjects(frameInfo, gpuCullSystem);
+                    if (gpuPhysics) {
+                        gpuNbodySystem->render(commandBuffer, *circleModel, camera);
+                    }
+                }
 				
                 lveRenderer.endSwapChainRenderPass(commandBuffer);
                 lveRenderer.endFrame();
             }
         }
 
+        physicsThread.stop();
         vkDeviceWaitIdle(lveDevice.device());
+        printFramePacingStats(lveRenderer.getFramePacingStats(), std::cout);
+        if (config.benchmarkFrames > 0) {
+            printFrameTimeSummary(
+                summarizeFrameTimes(std::move(benchmarkFrameTimes)),
+                std::string{ "present mode " } + presentModeName(lveRenderer.getPresentMode()),
+                std::cout);
+        }
+        if (parallelRecording) {
+            printRecordingStats(*secondaryRecorder, std::cout);
+        }
     }
 }  // namespace lve
\ No newline at end of file
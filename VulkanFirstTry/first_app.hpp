@@ -1,21 +1,45 @@
 #pragma once
 
+#include "body_store.hpp"
+#include "lve_descriptors.hpp"
 #include "lve_device.hpp"
 #include "lve_game_object.hpp"
 #include "lve_renderer.hpp"
 #include "lve_window.hpp"
+#include "physics_thread.hpp"
 
 // std
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 namespace lve {
+	struct FirstAppConfig {
+		// falls back to FIFO when the surface lacks it; IMMEDIATE and MAILBOX uncap the frame rate
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		// frames to time before closing, 0 to run until the window closes
+		uint32_t benchmarkFrames = 0;
+		// steps and draws the bodies with compute shaders instead of PhysicsSystem on its thread; they
+		// do not merge there and the center of mass cross stays put
+		bool gpuPhysics = false;
+		// records the objects one draw each into secondary command buffers on all cores instead of
+		// culling and instancing them, and prints the recording time per thread at exit; for
+		// measuring recording cost on large scenes
+		bool parallelRecording = false;
+		// draws every body above point size as a shaded sphere quad instead of a circle mesh
+		bool impostorBodies = false;
+		// 1 shows input the soonest, up to LveSwapChain::MAX_FRAMES_IN_FLIGHT overlaps CPU and GPU;
+		// the wait per frame is printed at exit to compare them
+		int framesInFlight = 2;
+	};
+
 	class FirstApp {
 	public:
 		static constexpr int WIDTH = 900;
 		static constexpr int HEIGHT = 900;
+		static constexpr uint32_t BENCHMARK_WARMUP_FRAMES = 120;  // pipeline and cache warm up, not timed
 
-		FirstApp();
+		FirstApp(const FirstAppConfig& config = {});
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
@@ -25,14 +49,22 @@ namespace lve {
 
 	private:
 		void loadGameObjects();
+		void loadPhysicsBodies();
+		// places the render objects between the two states of the snapshot, alpha being the share of the later one
+		void syncPhysicsObjects(const PhysicsSnapshot& snapshot, float alpha);
 
+		FirstAppConfig config;
 		LveWindow lveWindow{ WIDTH, HEIGHT, "Vulkan Tutorial" };
 		LveDevice lveDevice{ lveWindow };
-		LveRenderer lveRenderer{ lveWindow, lveDevice };
+		LveRenderer lveRenderer{ lveWindow, lveDevice, config.presentMode };
+
+		// declared after the device so it is destroyed before it
+		std::unique_ptr<LveDescriptorPool> globalPool{};
 		
 		std::vector<LveGameObject> gameObjects;
 		std::vector<LveGameObject> vectorField{};
 		std::vector<LveGameObject> physicsObjects;
+		BodyStore physicsBodies;
 		float unit;
 		std::shared_ptr<LveModel> circleModel;
 	};
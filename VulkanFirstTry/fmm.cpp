@@ -0,0 +1,514 @@
+#include "fmm.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace lve {
+
+    static uint64_t spreadBits(uint32_t v) {
+        uint64_t x = v & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffull;
+        x = (x | x << 16) & 0x1f0000ff0000ffull;
+        x = (x | x << 8) & 0x100f00f00f00f00full;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+        x = (x | x << 2) & 0x1249249249249249ull;
+        return x;
+    }
+
+    static int32_t compactBits(uint64_t x) {
+        x &= 0x1249249249249249ull;
+        x = (x | x >> 2) & 0x10c30c30c30c30c3ull;
+        x = (x | x >> 4) & 0x100f00f00f00f00full;
+        x = (x | x >> 8) & 0x1f0000ff0000ffull;
+        x = (x | x >> 16) & 0x1f00000000ffffull;
+        x = (x | x >> 32) & 0x1fffff;
+        return static_cast<int32_t>(x);
+    }
+
+    static uint64_t mortonKey(int32_t ix, int32_t iy, int32_t iz) {
+        return spreadBits(static_cast<uint32_t>(ix)) | spreadBits(static_cast<uint32_t>(iy)) << 1 |
+            spreadBits(static_cast<uint32_t>(iz)) << 2;
+    }
+
+    static double factorial(int n) {
+        double f = 1.0;
+        for (int k = 2; k <= n; k++) f *= k;
+        return f;
+    }
+
+    size_t FmmSolver::cellCount() const {
+        size_t cells = 0;
+        for (const auto& level : levels) cells += level.size();
+        return cells;
+    }
+
+    void FmmSolver::prepareTerms(int order) {
+        if (order == expansionOrder && !terms.empty()) return;
+        expansionOrder = order;
+
+        terms.clear();
+        termLookup.assign((order + 1) * (order + 1) * (order + 1), UINT32_MAX);
+        for (int n = 0; n <= order; n++) {
+            for (int x = n; x >= 0; x--) {
+                for (int y = n - x; y >= 0; y--) {
+                    const int z = n - x - y;
+                    termLookup[(x * (order + 1) + y) * (order + 1) + z] = static_cast<uint32_t>(terms.size());
+                    terms.push_back({ x, y, z, n });
+                }
+            }
+        }
+        assert(terms.size() <= MAX_TERMS && "Expansion order above MAX_ORDER");
+
+        inverseFactorial.resize(terms.size());
+        for (size_t k = 0; k < terms.size(); k++) {
+            inverseFactorial[k] = 1.0 / (factorial(terms[k].x) * factorial(terms[k].y) * factorial(terms[k].z));
+        }
+
+        m2lPairs.clear();
+        shiftPairs.clear();
+        for (uint32_t b = 0; b < terms.size(); b++) {
+            const Term& beta = terms[b];
+            for (uint32_t a = 0; a < terms.size(); a++) {
+                const Term& alpha = terms[a];
+                if (alpha.degree + beta.degree <= order) {
+                    const uint32_t sum = termIndex(alpha.x + beta.x, alpha.y + beta.y, alpha.z + beta.z);
+                    m2lPairs.push_back({ b, a, sum, inverseFactorial[b] / inverseFactorial[sum] });
+                }
+                if (alpha.x <= beta.x && alpha.y <= beta.y && alpha.z <= beta.z) {
+                    const uint32_t difference = termIndex(beta.x - alpha.x, beta.y - alpha.y, beta.z - alpha.z);
+                    shiftPairs.push_back(
+                        { b, a, difference, inverseFactorial[a] * inverseFactorial[difference] / inverseFactorial[b] });
+                }
+            }
+        }
+    }
+
+    void FmmSolver::monomials(double dx, double dy, double dz, double* out) const {
+        std::array<double, MAX_ORDER + 1> px, py, pz;
+        px[0] = py[0] = pz[0] = 1.0;
+        for (int k = 1; k <= expansionOrder; k++) {
+            px[k] = px[k - 1] * dx;
+            py[k] = py[k - 1] * dy;
+            pz[k] = pz[k - 1] * dz;
+        }
+        for (size_t k = 0; k < terms.size(); k++) {
+            out[k] = px[terms[k].x] * py[terms[k].y] * pz[terms[k].z];
+        }
+    }
+
+    void FmmSolver::selectHeavyBodies(
+        const float* x, const float* y, const float* z, const float* mass, const float* radius, size_t count) {
+        heavyBodies.clear();
+        double totalMass = 0.0;
+        for (size_t i = 0; i < count; i++) totalMass += mass[i];
+        const double threshold = HEAVY_MASS_FACTOR * totalMass / count;
+        for (size_t i = 0; i < count; i++) {
+            if (mass[i] > threshold) heavyBodies.push_back(static_cast<uint32_t>(i));
+        }
+        if (heavyBodies.size() > MAX_HEAVY_BODIES) {
+            std::partial_sort(heavyBodies.begin(), heavyBodies.begin() + MAX_HEAVY_BODIES, heavyBodies.end(),
+                [&](uint32_t a, uint32_t b) { return mass[a] > mass[b] || (mass[a] == mass[b] && a < b); });
+            heavyBodies.resize(MAX_HEAVY_BODIES);
+            std::sort(heavyBodies.begin(), heavyBodies.end());
+        }
+
+        heavyX.resize(heavyBodies.size());
+        heavyY.resize(heavyBodies.size());
+        heavyZ.resize(heavyBodies.size());
+        heavyMass.resize(heavyBodies.size());
+        heavyRadius.resize(heavyBodies.size());
+        for (size_t h = 0; h < heavyBodies.size(); h++) {
+            const uint32_t i = heavyBodies[h];
+            heavyX[h] = x[i];
+            heavyY[h] = y[i];
+            heavyZ[h] = z[i];
+            heavyMass[h] = mass[i];
+            heavyRadius[h] = radius[i];
+        }
+    }
+
+    void FmmSolver::buildTree(
+        const float* x, const float* y, const float* z, const float* mass, const float* radius, size_t count) {
+        float minX = x[0], minY = y[0], minZ = z[0];
+        float maxX = x[0], maxY = y[0], maxZ = z[0];
+        for (size_t i = 0; i < count; i++) {
+            minX = std::min(minX, x[i]);
+            minY = std::min(minY, y[i]);
+            minZ = std::min(minZ, z[i]);
+            maxX = std::max(maxX, x[i]);
+            maxY = std::max(maxY, y[i]);
+            maxZ = std::max(maxZ, z[i]);
+        }
+        rootSize = std::max({ maxX - minX, maxY - minY, maxZ - minZ }) * 1.001 + 1e-6;
+        rootMin[0] = minX;
+        rootMin[1] = minY;
+        rootMin[2] = minZ;
+
+        // Morton order on the finest grid, ties keep the input order; coarser keys are prefixes
+        const int32_t finestPerSide = 1 << MAX_LEVEL;
+        const double finestSize = rootSize / finestPerSide;
+        const auto gridCoordinate = [&](float p, int axis) {
+            const int32_t i = static_cast<int32_t>((p - rootMin[axis]) / finestSize);
+            return std::min(std::max(i, 0), finestPerSide - 1);
+        };
+        std::vector<std::pair<uint64_t, uint32_t>> keyed(count);
+        for (size_t i = 0; i < count; i++) {
+            keyed[i] = { mortonKey(gridCoordinate(x[i], 0), gridCoordinate(y[i], 1), gridCoordinate(z[i], 2)),
+                static_cast<uint32_t>(i) };
+        }
+        std::sort(keyed.begin(), keyed.end());
+
+        // Pick the depth with the lowest estimated cost: deeper trees shrink the near field, which
+        // grows with the squared leaf occupancy, but add cells with ~189 translations each. Counting
+        // occupied cells adapts this to clustered scenes where most of the grid is empty.
+        const double translationCost = FAR_FIELD_COST * m2lPairs.size() * 189.0;
+        double bestCost = 0.0;
+        leafLevel = MIN_LEVEL;
+        for (int level = MIN_LEVEL; level <= MAX_LEVEL; level++) {
+            const int shift = 3 * (MAX_LEVEL - level);
+            size_t occupied = 0;
+            double nearField = 0.0;
+            for (size_t first = 0; first < count;) {
+                size_t last = first + 1;
+                while (last < count && keyed[last].first >> shift == keyed[first].first >> shift) last++;
+                const double bodies = static_cast<double>(last - first);
+                nearField += 27.0 * bodies * bodies;
+                occupied++;
+                first = last;
+            }
+            const double cost = nearField + translationCost * occupied;
+            if (level == MIN_LEVEL || cost < bestCost) {
+                bestCost = cost;
+                leafLevel = level;
+            }
+            if (occupied == count || cost > 2.0 * bestCost) break;
+        }
+        const int leafShift = 3 * (MAX_LEVEL - leafLevel);
+
+        bodyOrder.resize(count);
+        sortKeys.resize(count);
+        sortedX.resize(count);
+        sortedY.resize(count);
+        sortedZ.resize(count);
+        sortedMass.resize(count);
+        sortedRadius.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            const uint32_t i = keyed[k].second;
+            sortKeys[k] = keyed[k].first >> leafShift;
+            bodyOrder[k] = i;
+            sortedX[k] = x[i];
+            sortedY[k] = y[i];
+            sortedZ[k] = z[i];
+            sortedMass[k] = mass[i];
+            sortedRadius[k] = radius[i];
+        }
+        // heavy bodies remain targets but only act through the direct sum in evaluateLeaf
+        for (size_t k = 0; k < count; k++) {
+            if (std::binary_search(heavyBodies.begin(), heavyBodies.end(), bodyOrder[k])) sortedMass[k] = 0.0f;
+        }
+
+        // occupied leaves are runs of equal keys, every coarser level groups runs of equal parents
+        levels.assign(leafLevel + 1, {});
+        std::vector<Cell>& leaves = levels[leafLevel];
+        for (size_t k = 0; k < count; k++) {
+            const uint64_t key = sortKeys[k];
+            if (leaves.empty() || leaves.back().key != key) {
+                leaves.push_back({ key, compactBits(key), compactBits(key >> 1), compactBits(key >> 2), 0, 0, 0,
+                    static_cast<uint32_t>(k), 0 });
+            }
+            leaves.back().bodyCount++;
+        }
+        for (int level = leafLevel - 1; level >= 0; level--) {
+            std::vector<Cell>& children = levels[level + 1];
+            std::vector<Cell>& parents = levels[level];
+            for (uint32_t c = 0; c < children.size(); c++) {
+                Cell& child = children[c];
+                const uint64_t key = child.key >> 3;
+                if (parents.empty() || parents.back().key != key) {
+                    parents.push_back({ key, child.ix >> 1, child.iy >> 1, child.iz >> 1, 0, c, 0, child.firstBody, 0 });
+                }
+                Cell& parent = parents.back();
+                parent.childCount++;
+                parent.bodyCount += child.bodyCount;
+                child.parent = static_cast<uint32_t>(parents.size() - 1);
+            }
+        }
+
+        multipoles.resize(leafLevel + 1);
+        multipoleCenters.resize(leafLevel + 1);
+        locals.resize(leafLevel + 1);
+        for (int level = MIN_LEVEL; level <= leafLevel; level++) {
+            multipoles[level].assign(levels[level].size() * terms.size(), 0.0);
+            multipoleCenters[level].assign(levels[level].size() * 3, 0.0);
+            locals[level].assign(levels[level].size() * terms.size(), 0.0);
+        }
+    }
+
+    int64_t FmmSolver::findCell(int level, int32_t ix, int32_t iy, int32_t iz) const {
+        const int32_t cellsPerSide = 1 << level;
+        if (ix < 0 || iy < 0 || iz < 0 || ix >= cellsPerSide || iy >= cellsPerSide || iz >= cellsPerSide) {
+            return -1;
+        }
+        const uint64_t key = mortonKey(ix, iy, iz);
+        const std::vector<Cell>& cells = levels[level];
+        const auto it = std::lower_bound(
+            cells.begin(), cells.end(), key, [](const Cell& cell, uint64_t k) { return cell.key < k; });
+        if (it == cells.end() || it->key != key) return -1;
+        return it - cells.begin();
+    }
+
+    void FmmSolver::cellCenter(int level, const Cell& cell, double out[3]) const {
+        const double size = rootSize / (1 << level);
+        out[0] = rootMin[0] + (cell.ix + 0.5) * size;
+        out[1] = rootMin[1] + (cell.iy + 0.5) * size;
+        out[2] = rootMin[2] + (cell.iz + 0.5) * size;
+    }
+
+    // M_alpha = sum m (-d)^alpha / alpha!, d the offset from the leaf's center of mass
+    void FmmSolver::particleToMultipole(uint32_t c) {
+        const Cell& cell = levels[leafLevel][c];
+        double* center = &multipoleCenters[leafLevel][3 * c];
+        double mass = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+        for (uint32_t k = cell.firstBody; k < cell.firstBody + cell.bodyCount; k++) {
+            mass += sortedMass[k];
+            mx += static_cast<double>(sortedMass[k]) * sortedX[k];
+            my += static_cast<double>(sortedMass[k]) * sortedY[k];
+            mz += static_cast<double>(sortedMass[k]) * sortedZ[k];
+        }
+        if (mass > 0.0) {
+            center[0] = mx / mass;
+            center[1] = my / mass;
+            center[2] = mz / mass;
+        }
+        else {
+            cellCenter(leafLevel, cell, center);
+        }
+
+        double* multipole = &multipoles[leafLevel][c * terms.size()];
+        std::array<double, MAX_TERMS> powers;
+        for (uint32_t k = cell.firstBody; k < cell.firstBody + cell.bodyCount; k++) {
+            monomials(center[0] - sortedX[k], center[1] - sortedY[k], center[2] - sortedZ[k], powers.data());
+            for (size_t t = 0; t < terms.size(); t++) {
+                multipole[t] += sortedMass[k] * powers[t] * inverseFactorial[t];
+            }
+        }
+    }
+
+    // M'_beta = sum over alpha <= beta of M_alpha (-s)^(beta - alpha) / (beta - alpha)!, s the
+    // child center relative to the parent's. M_0 is the mass, which places the parent's center.
+    void FmmSolver::multipoleToMultipole(int level, uint32_t c) {
+        const Cell& cell = levels[level][c];
+        double* center = &multipoleCenters[level][3 * c];
+        double mass = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+        for (uint32_t child = cell.firstChild; child < cell.firstChild + cell.childCount; child++) {
+            const double childMass = multipoles[level + 1][child * terms.size()];
+            const double* childCenter = &multipoleCenters[level + 1][3 * child];
+            mass += childMass;
+            mx += childMass * childCenter[0];
+            my += childMass * childCenter[1];
+            mz += childMass * childCenter[2];
+        }
+        if (mass > 0.0) {
+            center[0] = mx / mass;
+            center[1] = my / mass;
+            center[2] = mz / mass;
+        }
+        else {
+            cellCenter(level, cell, center);
+        }
+
+        double* multipole = &multipoles[level][c * terms.size()];
+        std::array<double, MAX_TERMS> shift;
+        for (uint32_t child = cell.firstChild; child < cell.firstChild + cell.childCount; child++) {
+            const double* childCenter = &multipoleCenters[level + 1][3 * child];
+            monomials(center[0] - childCenter[0], center[1] - childCenter[1], center[2] - childCenter[2], shift.data());
+            const double* source = &multipoles[level + 1][child * terms.size()];
+            for (const TermPair& pair : shiftPairs) {
+                multipole[pair.outer] += source[pair.inner] * shift[pair.combined] * inverseFactorial[pair.combined];
+            }
+        }
+    }
+
+    // Taylor coefficients T_gamma = d^gamma(1/r) / gamma! at R, by the recurrence
+    // n r^2 T_gamma = -(2n - 1) sum R_i T_(gamma - e_i) - (n - 1) sum T_(gamma - 2e_i).
+    void FmmSolver::taylorCoefficients(const double R[3], double* T) const {
+        const double r2 = R[0] * R[0] + R[1] * R[1] + R[2] * R[2];
+        T[0] = 1.0 / std::sqrt(r2);
+        for (size_t t = 1; t < terms.size(); t++) {
+            const Term& term = terms[t];
+            const int g[3] = { term.x, term.y, term.z };
+            double first = 0.0, second = 0.0;
+            for (int axis = 0; axis < 3; axis++) {
+                int lower[3] = { g[0], g[1], g[2] };
+                if (g[axis] >= 1) {
+                    lower[axis] = g[axis] - 1;
+                    first += R[axis] * T[termIndex(lower[0], lower[1], lower[2])];
+                }
+                if (g[axis] >= 2) {
+                    lower[axis] = g[axis] - 2;
+                    second += T[termIndex(lower[0], lower[1], lower[2])];
+                }
+            }
+            const int n = term.degree;
+            T[t] = -((2 * n - 1) * first + (n - 1) * second) / (n * r2);
+        }
+    }
+
+    // The local expansion is phi(e + y) = sum L_beta y^beta. It inherits the parent's expansion
+    // shifted to this center and adds every well separated cell of the interaction list: the
+    // children of the parent's neighbours that are not adjacent to this cell.
+    void FmmSolver::downwardPass(int level, uint32_t c) {
+        const Cell& cell = levels[level][c];
+        double center[3];
+        cellCenter(level, cell, center);
+        double* local = &locals[level][c * terms.size()];
+        std::array<double, MAX_TERMS> coefficients;
+        if (level > MIN_LEVEL) {
+            std::array<double, MAX_TERMS> shift;
+            double parentCenter[3];
+            const Cell& parent = levels[level - 1][cell.parent];
+            cellCenter(level - 1, parent, parentCenter);
+            monomials(center[0] - parentCenter[0], center[1] - parentCenter[1], center[2] - parentCenter[2],
+                shift.data());
+            const double* source = &locals[level - 1][cell.parent * terms.size()];
+            // L'_alpha = sum over beta >= alpha of L_beta binomial(beta, alpha) t^(beta - alpha)
+            for (const TermPair& pair : shiftPairs) {
+                local[pair.inner] += source[pair.outer] * pair.coefficient * shift[pair.combined];
+            }
+        }
+
+        for (int dz = -1; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    const int64_t neighbour =
+                        findCell(level - 1, (cell.ix >> 1) + dx, (cell.iy >> 1) + dy, (cell.iz >> 1) + dz);
+                    if (neighbour < 0) continue;
+                    const Cell& parent = levels[level - 1][neighbour];
+                    for (uint32_t s = parent.firstChild; s < parent.firstChild + parent.childCount; s++) {
+                        const Cell& source = levels[level][s];
+                        if (std::abs(source.ix - cell.ix) <= 1 && std::abs(source.iy - cell.iy) <= 1 &&
+                            std::abs(source.iz - cell.iz) <= 1) {
+                            continue;
+                        }
+
+                        const double* sourceCenter = &multipoleCenters[level][3 * s];
+                        const double R[3] = {
+                            center[0] - sourceCenter[0], center[1] - sourceCenter[1], center[2] - sourceCenter[2] };
+                        taylorCoefficients(R, coefficients.data());
+                        const double* T = coefficients.data();
+
+                        // L_beta += sum_alpha M_alpha D_(alpha + beta) / beta!
+                        const double* multipole = &multipoles[level][s * terms.size()];
+                        for (const TermPair& pair : m2lPairs) {
+                            local[pair.outer] += multipole[pair.inner] * pair.coefficient * T[pair.combined];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Far field as the gradient of the local expansion, near field summed directly over the 27
+    // neighbouring leaves, which are contiguous runs of the Morton ordered bodies.
+    void FmmSolver::evaluateLeaf(uint32_t c, DirectKernel kernel) {
+        const Cell& cell = levels[leafLevel][c];
+        double center[3];
+        cellCenter(leafLevel, cell, center);
+        const double* local = &locals[leafLevel][c * terms.size()];
+        std::array<double, MAX_TERMS> powers;
+
+        std::array<int64_t, 27> neighbours;
+        size_t neighbourCount = 0;
+        for (int dz = -1; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    const int64_t n = findCell(leafLevel, cell.ix + dx, cell.iy + dy, cell.iz + dz);
+                    if (n >= 0) neighbours[neighbourCount++] = n;
+                }
+            }
+        }
+        const GravitySources sources{
+            sortedX.data(), sortedY.data(), sortedZ.data(), sortedMass.data(), sortedRadius.data() };
+        const GravitySources heavySources{
+            heavyX.data(), heavyY.data(), heavyZ.data(), heavyMass.data(), heavyRadius.data() };
+
+        for (uint32_t k = cell.firstBody; k < cell.firstBody + cell.bodyCount; k++) {
+            monomials(sortedX[k] - center[0], sortedY[k] - center[1], sortedZ[k] - center[2], powers.data());
+            double a[3] = { 0.0, 0.0, 0.0 };
+            for (size_t t = 1; t < terms.size(); t++) {
+                const Term& term = terms[t];
+                if (term.x > 0) a[0] += local[t] * term.x * powers[termIndex(term.x - 1, term.y, term.z)];
+                if (term.y > 0) a[1] += local[t] * term.y * powers[termIndex(term.x, term.y - 1, term.z)];
+                if (term.z > 0) a[2] += local[t] * term.z * powers[termIndex(term.x, term.y, term.z - 1)];
+            }
+
+            if (!heavyBodies.empty()) {
+                float heavyField[3];
+                kernel(heavySources, 0, heavyBodies.size(), sortedX[k], sortedY[k], sortedZ[k], sortedRadius[k],
+                    heavyField);
+                a[0] += heavyField[0];
+                a[1] += heavyField[1];
+                a[2] += heavyField[2];
+            }
+            for (size_t n = 0; n < neighbourCount; n++) {
+                const Cell& near = levels[leafLevel][neighbours[n]];
+                float nearField[3];
+                kernel(sources, near.firstBody, near.firstBody + near.bodyCount, sortedX[k], sortedY[k], sortedZ[k],
+                    sortedRadius[k], nearField);
+                a[0] += nearField[0];
+                a[1] += nearField[1];
+                a[2] += nearField[2];
+            }
+
+            const uint32_t i = bodyOrder[k];
+            outX[i] = static_cast<float>(a[0]);
+            outY[i] = static_cast<float>(a[1]);
+            outZ[i] = static_cast<float>(a[2]);
+        }
+    }
+
+    void FmmSolver::evaluate(
+        const float* x,
+        const float* y,
+        const float* z,
+        const float* mass,
+        const float* radius,
+        size_t count,
+        int order,
+        SimdLevel simdLevel,
+        ThreadPool& pool) {
+        outX.assign(count, 0.0f);
+        outY.assign(count, 0.0f);
+        outZ.assign(count, 0.0f);
+        if (count == 0) return;
+
+        prepareTerms(std::min(std::max(order, 1), MAX_ORDER));
+        selectHeavyBodies(x, y, z, mass, radius, count);
+        buildTree(x, y, z, mass, radius, count);
+
+        // every pass only writes the cells it is given, so tiles of cells run independently
+        constexpr size_t CELL_TILE = 16;
+        pool.parallelFor(levels[leafLevel].size(), CELL_TILE, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) particleToMultipole(static_cast<uint32_t>(c));
+        });
+        for (int level = leafLevel - 1; level >= MIN_LEVEL; level--) {
+            pool.parallelFor(levels[level].size(), CELL_TILE, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) multipoleToMultipole(level, static_cast<uint32_t>(c));
+            });
+        }
+        for (int level = MIN_LEVEL; level <= leafLevel; level++) {
+            pool.parallelFor(levels[level].size(), CELL_TILE, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) downwardPass(level, static_cast<uint32_t>(c));
+            });
+        }
+        const DirectKernel kernel = selectDirectKernel(simdLevel);
+        pool.parallelFor(levels[leafLevel].size(), CELL_TILE, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) evaluateLeaf(static_cast<uint32_t>(c), kernel);
+        });
+    }
+
+}  // namespace lve
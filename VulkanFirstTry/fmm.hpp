@@ -0,0 +1,125 @@
+#pragma once
+
+#include "gravity_kernels.hpp"
+#include "thread_pool.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+    // Fast multipole gravity with Cartesian Taylor expansions of a configurable order. Bodies are
+    // sorted along a Morton curve into a uniform octree that only stores occupied cells; its depth
+    // balances the near field against the far field for the scene and order at hand. Multipoles
+    // are expanded about each cell's center of mass, which keeps a cell dominated by one heavy body
+    // accurate, and local expansions about the geometric centers. Far cells interact through
+    // multipole-to-local translations, neighbouring leaves through the direct-sum kernels. A few
+    // bodies far heavier than the rest, like a central star, stay out of the expansions and pull on
+    // every body directly, since one of them next to a cell boundary dominates the truncation error.
+    // Like BarnesHutTree it works in plain simulation units: the accelerations are
+    // sum(m * (p_j - p) / |p_j - p|^3), overlapping near-field pairs excluded.
+    class FmmSolver {
+    public:
+        static constexpr int MAX_ORDER = 10;
+        static constexpr int MIN_LEVEL = 2;  // the first level with well separated cells
+        static constexpr int MAX_LEVEL = 16;
+        // cost of one multipole-to-local term against one near-field pair in the SIMD kernels
+        static constexpr double FAR_FIELD_COST = 10.0;
+        // bodies above this multiple of the mean mass are summed directly, at most MAX_HEAVY_BODIES
+        static constexpr float HEAVY_MASS_FACTOR = 1000.0f;
+        static constexpr size_t MAX_HEAVY_BODIES = 32;
+        static constexpr size_t MAX_TERMS = (MAX_ORDER + 1) * (MAX_ORDER + 2) * (MAX_ORDER + 3) / 6;
+
+        FmmSolver() = default;
+
+        FmmSolver(const FmmSolver&) = delete;
+        FmmSolver& operator=(const FmmSolver&) = delete;
+
+        // Accelerations of every body, written to accelX/Y/Z() in input order. `order` is clamped
+        // to [1, MAX_ORDER]; the far-field error falls roughly as 2^-order.
+        void evaluate(
+            const float* x,
+            const float* y,
+            const float* z,
+            const float* mass,
+            const float* radius,
+            size_t count,
+            int order,
+            SimdLevel simdLevel,
+            ThreadPool& pool);
+
+        const std::vector<float>& accelX() const { return outX; }
+        const std::vector<float>& accelY() const { return outY; }
+        const std::vector<float>& accelZ() const { return outZ; }
+
+        int depth() const { return leafLevel; }
+        size_t cellCount() const;
+
+    private:
+        struct Cell {
+            uint64_t key;  // Morton code at the cell's level
+            int32_t ix, iy, iz;
+            uint32_t parent;
+            uint32_t firstChild;
+            uint32_t childCount;
+            uint32_t firstBody;  // range in Morton order
+            uint32_t bodyCount;
+        };
+
+        // multi-index term of an expansion, ordered by total degree
+        struct Term {
+            int x, y, z, degree;
+        };
+
+        // two terms a translation combines and the term they add up to or differ by
+        struct TermPair {
+            uint32_t outer, inner, combined;
+            double coefficient;
+        };
+
+        void prepareTerms(int order);
+        uint32_t termIndex(int x, int y, int z) const {
+            return termLookup[(x * (expansionOrder + 1) + y) * (expansionOrder + 1) + z];
+        }
+        void selectHeavyBodies(const float* x, const float* y, const float* z, const float* mass, const float* radius, size_t count);
+        void buildTree(const float* x, const float* y, const float* z, const float* mass, const float* radius, size_t count);
+        int64_t findCell(int level, int32_t ix, int32_t iy, int32_t iz) const;
+        void cellCenter(int level, const Cell& cell, double out[3]) const;
+        void taylorCoefficients(const double R[3], double* out) const;
+        void monomials(double dx, double dy, double dz, double* out) const;
+
+        void particleToMultipole(uint32_t cell);
+        void multipoleToMultipole(int level, uint32_t cell);
+        void downwardPass(int level, uint32_t cell);
+        void evaluateLeaf(uint32_t cell, DirectKernel kernel);
+
+        int expansionOrder = 0;
+        std::vector<Term> terms;
+        std::vector<uint32_t> termLookup;
+        std::vector<double> inverseFactorial;  // 1 / alpha!
+        // outer beta, inner alpha, combined alpha + beta with |alpha + beta| <= order,
+        // coefficient (alpha + beta)! / beta!
+        std::vector<TermPair> m2lPairs;
+        // outer beta, inner alpha <= beta componentwise, combined beta - alpha,
+        // coefficient binomial(beta, alpha)
+        std::vector<TermPair> shiftPairs;
+
+        int leafLevel = 0;
+        double rootMin[3]{};
+        double rootSize = 1.0;
+        std::vector<std::vector<Cell>> levels;
+        std::vector<std::vector<double>> multipoles;  // per level, terms.size() per cell
+        std::vector<std::vector<double>> locals;
+        std::vector<std::vector<double>> multipoleCenters;  // per level, center of mass of each cell
+
+        // bodies in Morton order
+        std::vector<uint32_t> bodyOrder;
+        std::vector<float> sortedX, sortedY, sortedZ, sortedMass, sortedRadius;
+        std::vector<uint64_t> sortKeys;
+        std::vector<uint32_t> heavyBodies;  // input indices, massless inside the tree
+        std::vector<float> heavyX, heavyY, heavyZ, heavyMass, heavyRadius;
+
+        std::vector<float> outX, outY, outZ;
+    };
+}  // namespace lve
@@ -0,0 +1,43 @@
+#include "frame_benchmark.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+namespace lve {
+    // smallest sample with at least share of all samples at or below it
+    static double percentile(const std::vector<double>& sorted, double share) {
+        const size_t rank = static_cast<size_t>(std::ceil(share * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+    FrameTimeSummary summarizeFrameTimes(std::vector<double> frameSeconds) {
+        FrameTimeSummary summary{};
+        summary.frameCount = frameSeconds.size();
+        if (frameSeconds.empty()) return summary;
+
+        std::sort(frameSeconds.begin(), frameSeconds.end());
+        const double total = std::accumulate(frameSeconds.begin(), frameSeconds.end(), 0.0);
+        summary.meanMilliseconds = total / frameSeconds.size() * 1000.0;
+        summary.framesPerSecond = total > 0.0 ? frameSeconds.size() / total : 0.0;
+        summary.p50Milliseconds = percentile(frameSeconds, 0.50) * 1000.0;
+        summary.p95Milliseconds = percentile(frameSeconds, 0.95) * 1000.0;
+        summary.p99Milliseconds = percentile(frameSeconds, 0.99) * 1000.0;
+        summary.maxMilliseconds = frameSeconds.back() * 1000.0;
+        return summary;
+    }
+
+    void printFrameTimeSummary(const FrameTimeSummary& summary, const std::string& label, std::ostream& out) {
+        out << label << ", " << summary.frameCount << " frames\n";
+        out << std::setw(10) << "mean ms" << std::setw(10) << "fps" << std::setw(10) << "p50 ms" << std::setw(10)
+            << "p95 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << "\n";
+        out << std::fixed << std::setprecision(3);
+        out << std::setw(10) << summary.meanMilliseconds << std::setw(10) << std::setprecision(1)
+            << summary.framesPerSecond << std::setprecision(3) << std::setw(10) << summary.p50Milliseconds
+            << std::setw(10) << summary.p95Milliseconds << std::setw(10) << summary.p99Milliseconds << std::setw(10)
+            << summary.maxMilliseconds << "\n";
+        out << std::defaultfloat << std::flush;
+    }
+}  // namespace lve
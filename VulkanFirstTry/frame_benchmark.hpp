@@ -0,0 +1,24 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+    struct FrameTimeSummary {
+        size_t frameCount{};
+        double meanMilliseconds{};
+        double framesPerSecond{};  // from the mean
+        // nearest rank percentiles, p99 being the frame time 99% of the frames stay under
+        double p50Milliseconds{};
+        double p95Milliseconds{};
+        double p99Milliseconds{};
+        double maxMilliseconds{};
+    };
+
+    // frame times in seconds, in any order
+    FrameTimeSummary summarizeFrameTimes(std::vector<double> frameSeconds);
+    void printFrameTimeSummary(const FrameTimeSummary& summary, const std::string& label, std::ostream& out);
+}  // namespace lve
@@ -0,0 +1,121 @@
+#include "frame_writer.hpp"
+
+// std
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+static const char* const PIPE_MODE = "wb";
+#else
+static const char* const PIPE_MODE = "w";  // glibc turns down the b
+#endif
+
+namespace lve {
+    const char* frameOutputName(FrameOutput output) {
+        switch (output) {
+        case FrameOutput::Raw: return "raw";
+        case FrameOutput::Ppm: return "ppm";
+        case FrameOutput::Pipe: return "pipe";
+        }
+        return "unknown";
+    }
+
+    // the directory part of a file path or prefix, so frames/run1_ works without a mkdir
+    static void createParentDirectory(const std::string& path) {
+        const std::filesystem::path parent = std::filesystem::path{ path }.parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent);
+        }
+    }
+
+    FrameWriter::FrameWriter(FrameOutput output, std::string target, uint32_t width, uint32_t height)
+        : output{ output }, target{ std::move(target) }, width{ width }, height{ height } {
+        switch (output) {
+        case FrameOutput::Raw:
+            createParentDirectory(this->target);
+            stream = std::fopen(this->target.c_str(), "wb");
+            break;
+        case FrameOutput::Ppm:
+            createParentDirectory(this->target);
+            rgbRow.resize(static_cast<size_t>(width) * 3);
+            return;
+        case FrameOutput::Pipe:
+            stream = popen(this->target.c_str(), PIPE_MODE);
+            break;
+        }
+        if (stream == nullptr) {
+            throw std::runtime_error("failed to open frame output: " + this->target);
+        }
+    }
+
+    FrameWriter::~FrameWriter() {
+        if (stream == nullptr) return;
+        if (output == FrameOutput::Pipe) {
+            pclose(stream);
+        }
+        else {
+            std::fclose(stream);
+        }
+    }
+
+    void FrameWriter::writeBytes(std::FILE* file, const void* data, size_t size) {
+        if (std::fwrite(data, 1, size, file) != size) {
+            throw std::runtime_error("failed to write frame to " + target);
+        }
+        bytesWritten += size;
+    }
+
+    void FrameWriter::write(uint64_t frameNumber, const uint8_t* rgba) {
+        const size_t frameBytes = static_cast<size_t>(width) * height * 4;
+        if (output != FrameOutput::Ppm) {
+            writeBytes(stream, rgba, frameBytes);
+            framesWritten++;
+            return;
+        }
+
+        char number[32];
+        std::snprintf(number, sizeof(number), "%06llu.ppm", static_cast<unsigned long long>(frameNumber));
+        const std::string path = target + number;
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("failed to open frame output: " + path);
+        }
+        try {
+            const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+            writeBytes(file, header.data(), header.size());
+            for (uint32_t y = 0; y < height; y++) {
+                const uint8_t* pixel = rgba + static_cast<size_t>(y) * width * 4;
+                for (uint32_t x = 0; x < width; x++, pixel += 4) {
+                    rgbRow[x * 3 + 0] = pixel[0];
+                    rgbRow[x * 3 + 1] = pixel[1];
+                    rgbRow[x * 3 + 2] = pixel[2];
+                }
+                writeBytes(file, rgbRow.data(), rgbRow.size());
+            }
+        }
+        catch (...) {
+            std::fclose(file);
+            throw;
+        }
+        std::fclose(file);
+        framesWritten++;
+    }
+
+    void FrameWriter::close() {
+        if (stream == nullptr) return;
+        std::FILE* closing = stream;
+        stream = nullptr;
+        if (output == FrameOutput::Pipe) {
+            const int status = pclose(closing);
+            if (status != 0) {
+                throw std::runtime_error(
+                    "frame encoder '" + target + "' exited with status " + std::to_string(status));
+            }
+        }
+        else if (std::fclose(closing) != 0) {
+            throw std::runtime_error("failed to write frame to " + target);
+        }
+    }
+}  // namespace lve
@@ -0,0 +1,49 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace lve {
+    enum class FrameOutput {
+        Raw,   // every frame appended to the file target, for ffmpeg -f rawvideo -pixel_format rgba
+        Ppm,   // one binary PPM per frame, named target followed by the six digit frame number
+        Pipe,  // raw frames written to the standard input of the command target, an encoder say
+    };
+
+    const char* frameOutputName(FrameOutput output);
+
+    // Streams rendered frames out of the process. A frame is width * height tightly packed 8 bit
+    // RGBA pixels, top row first; PPM drops the alpha. Throws std::runtime_error when the output
+    // cannot be opened or written.
+    class FrameWriter {
+    public:
+        FrameWriter(FrameOutput output, std::string target, uint32_t width, uint32_t height);
+        ~FrameWriter();
+
+        FrameWriter(const FrameWriter&) = delete;
+        FrameWriter& operator=(const FrameWriter&) = delete;
+
+        void write(uint64_t frameNumber, const uint8_t* rgba);
+        // flushes the file or waits for the encoder to exit, throwing if it failed
+        void close();
+
+        uint64_t getFramesWritten() const { return framesWritten; }
+        uint64_t getBytesWritten() const { return bytesWritten; }
+
+    private:
+        void writeBytes(std::FILE* file, const void* data, size_t size);
+
+        const FrameOutput output;
+        const std::string target;
+        const uint32_t width;
+        const uint32_t height;
+
+        std::FILE* stream = nullptr;  // the raw file or the encoder's stdin
+        std::vector<uint8_t> rgbRow;
+        uint64_t framesWritten = 0;
+        uint64_t bytesWritten = 0;
+    };
+}  // namespace lve
@@ -0,0 +1,258 @@
+#include "gpu_cull_system.hpp"
+
+#include "lve_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    struct CullPushConstantData {
+        glm::vec4 planes[6];
+        uint32_t instanceCount;
+        uint32_t drawCount;
+    };
+
+    GpuCullSystem::GpuCullSystem(LveDevice& device)
+        : lveDevice{ device }, frames(LveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+        createDescriptors();
+        createPipelineLayout();
+        createPipeline();
+    }
+
+    GpuCullSystem::~GpuCullSystem() {
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void GpuCullSystem::createDescriptors() {
+        const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+        descriptorPool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(frameCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * frameCount)
+            .build();
+        setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+    }
+
+    void GpuCullSystem::createPipelineLayout() {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create cull pipeline layout!");
+        }
+    }
+
+    void GpuCullSystem::createPipeline() {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+        cullPipeline = std::make_unique<LvePipeline>(lveDevice, "../cull_instances.comp.spv", pipelineLayout);
+    }
+
+    // The buffers of a frame index are only touched again after beginFrame waited on that frame's
+    // fence, so they can be replaced and their descriptor set rewritten right away.
+    void GpuCullSystem::reserve(FrameResources& frame, uint32_t instanceCount, uint32_t drawCount) {
+        bool rewrite = frame.descriptorSet == VK_NULL_HANDLE;
+
+        if (frame.instanceBuffer == nullptr || frame.instanceBuffer->getInstanceCount() < instanceCount) {
+            uint32_t capacity = frame.instanceBuffer != nullptr ? frame.instanceBuffer->getInstanceCount() * 2 : 256;
+            capacity = std::max(capacity, instanceCount);
+            frame.instanceBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(SimpleRenderSystem::InstanceData),
+                capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            frame.visibleBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(SimpleRenderSystem::InstanceData),
+                capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (frame.instanceBuffer->map() != VK_SUCCESS) {
+                throw std::runtime_error("failed to map cull instance buffer!");
+            }
+            rewrite = true;
+        }
+
+        if (frame.drawBuffer == nullptr || frame.drawBuffer->getInstanceCount() < drawCount) {
+            frame.drawBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(DrawCommand),
+                std::max(drawCount, 16u),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            if (frame.drawBuffer->map() != VK_SUCCESS) {
+                throw std::runtime_error("failed to map cull draw buffer!");
+            }
+            rewrite = true;
+        }
+
+        if (!rewrite) return;
+        auto instanceInfo = frame.instanceBuffer->descriptorInfo();
+        auto visibleInfo = frame.visibleBuffer->descriptorInfo();
+        auto drawInfo = frame.drawBuffer->descriptorInfo();
+        LveDescriptorWriter writer{ *setLayout, *descriptorPool };
+        writer.writeBuffer(0, &instanceInfo).writeBuffer(1, &visibleInfo).writeBuffer(2, &drawInfo);
+        if (frame.descriptorSet == VK_NULL_HANDLE) {
+            if (!writer.build(frame.descriptorSet)) {
+                throw std::runtime_error("failed to allocate cull descriptor set!");
+            }
+        }
+        else {
+            writer.overwrite(frame.descriptorSet);
+        }
+    }
+
+    void GpuCullSystem::cull(
+        VkCommandBuffer commandBuffer,
+        int frameIndex,
+        const std::vector<std::vector<LveGameObject>*>& objectLists,
+        const LveCamera& camera) {
+        FrameResources& frame = frames[frameIndex];
+        const uint32_t instanceCount = SimpleRenderSystem::groupInstances(objectLists, frame.draws);
+        if (instanceCount == 0) {
+            frame.draws.clear();
+            return;
+        }
+
+        const uint32_t drawCount = static_cast<uint32_t>(frame.draws.size());
+        reserve(frame, instanceCount, drawCount);
+        SimpleRenderSystem::writeInstances(
+            objectLists,
+            frame.draws,
+            static_cast<SimpleRenderSystem::InstanceData*>(frame.instanceBuffer->getMappedMemory()));
+
+        // instanceCount starts at zero and is counted up by the shader
+        auto* commands = static_cast<DrawCommand*>(frame.drawBuffer->getMappedMemory());
+        for (uint32_t i = 0; i < drawCount; i++) {
+            const auto& draw = frame.draws[i];
+            commands[i] = {};
+            commands[i].command.indexCount = draw.model->getDrawCount();
+            commands[i].boundingRadius = draw.model->getBoundingRadius();
+            commands[i].instanceBegin = draw.firstInstance;
+            commands[i].instanceEnd = draw.firstInstance + draw.instanceCount;
+        }
+
+        CullPushConstantData push{};
+        const auto planes = frustumPlanes(camera.getProjection() * camera.getView());
+        std::copy(planes.begin(), planes.end(), push.planes);
+        push.instanceCount = instanceCount;
+        push.drawCount = drawCount;
+
+        cullPipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &frame.descriptorSet,
+            0,
+            nullptr);
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstantData),
+            &push);
+        vkCmdDispatch(commandBuffer, (instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // the draws read the counts as indirect commands and the compacted instances as vertices,
+        // readVisibleCounts reads the counts on the host
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask =
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    }
+
+    std::vector<uint32_t> GpuCullSystem::readVisibleCounts(int frameIndex) const {
+        const FrameResources& frame = frames[frameIndex];
+        std::vector<uint32_t> counts(frame.draws.size());
+        if (counts.empty()) return counts;
+
+        const auto* commands = static_cast<const DrawCommand*>(frame.drawBuffer->getMappedMemory());
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] = commands[i].command.instanceCount;
+        }
+        return counts;
+    }
+
+    std::vector<uint32_t> GpuCullSystem::cullOnHost(
+        const std::vector<std::vector<LveGameObject>*>& objectLists, const LveCamera& camera) {
+        std::vector<SimpleRenderSystem::InstanceGroup> groups;
+        const uint32_t instanceCount = SimpleRenderSystem::groupInstances(objectLists, groups);
+        std::vector<SimpleRenderSystem::InstanceData> instances(instanceCount);
+        SimpleRenderSystem::writeInstances(objectLists, groups, instances.data());
+
+        const auto planes = frustumPlanes(camera.getProjection() * camera.getView());
+        std::vector<uint32_t> counts(groups.size(), 0);
+        for (size_t g = 0; g < groups.size(); g++) {
+            for (uint32_t i = groups[g].firstInstance; i < groups[g].firstInstance + groups[g].instanceCount; i++) {
+                const glm::mat4& model = instances[i].modelMatrix;
+                const float scale = glm::max(
+                    glm::length(glm::vec3(model[0])),
+                    glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                if (isSphereVisible(planes, glm::vec3(model[3]), groups[g].model->getBoundingRadius() * scale)) {
+                    counts[g]++;
+                }
+            }
+        }
+        return counts;
+    }
+
+    // Gribb and Hartmann: each plane is the last row of the matrix plus or minus another row. The
+    // depth range is 0 to 1 (GLM_FORCE_DEPTH_ZERO_TO_ONE), so the near plane is the third row alone.
+    std::array<glm::vec4, 6> GpuCullSystem::frustumPlanes(const glm::mat4& projectionView) {
+        auto row = [&](int i) {
+            return glm::vec4{ projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i] };
+        };
+        std::array<glm::vec4, 6> planes = {
+            row(3) + row(0),
+            row(3) - row(0),
+            row(3) + row(1),
+            row(3) - row(1),
+            row(2),
+            row(3) - row(2),
+        };
+        for (auto& plane : planes) {
+            plane = plane / glm::length(glm::vec3(plane));
+        }
+        return planes;
+    }
+
+    bool GpuCullSystem::isSphereVisible(const std::array<glm::vec4, 6>& planes, glm::vec3 center, float radius) {
+        for (const auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+        }
+        return true;
+    }
+
+}  // namespace lve
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_camera.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_pipeline.hpp"
+#include "simple_render_system.hpp"
+
+// std
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace lve {
+    // Frustum culling on the GPU. A compute pass tests the bounding sphere of every instance against
+    // the camera, appends the visible ones to a compacted buffer and counts them into one
+    // VkDrawIndirectCommand per model, which SimpleRenderSystem::renderCulledGameObjects then draws
+    // without the CPU ever looking at the result.
+    class GpuCullSystem {
+    public:
+        static constexpr uint32_t WORKGROUP_SIZE = 64;  // local_size_x of cull_instances.comp
+
+        // Layout shared with cull_instances.comp. The 32 bytes are also the stride of the indirect
+        // draws; the shader fills in command.instanceCount. Models without an index buffer are drawn
+        // with vkCmdDrawIndirect from the same bytes: with firstIndex and vertexOffset left at zero,
+        // the first 16 of them read as a VkDrawIndirectCommand for indexCount vertices.
+        struct DrawCommand {
+            VkDrawIndexedIndirectCommand command;
+            float boundingRadius;    // of the model, scaled per instance by its largest axis
+            uint32_t instanceBegin;  // range of this model in the instance buffer
+            uint32_t instanceEnd;
+        };
+
+        GpuCullSystem(LveDevice& device);
+        ~GpuCullSystem();
+
+        GpuCullSystem(const GpuCullSystem&) = delete;
+        GpuCullSystem& operator=(const GpuCullSystem&) = delete;
+
+        // Uploads the objects of all lists to the buffers of frameIndex and records the cull pass and
+        // the barrier that makes its output readable by indirect draws. Must be recorded outside a
+        // render pass, before renderCulledGameObjects.
+        void cull(
+            VkCommandBuffer commandBuffer,
+            int frameIndex,
+            const std::vector<std::vector<LveGameObject>*>& objectLists,
+            const LveCamera& camera);
+
+        // one per model, in the order of the draw commands
+        const std::vector<SimpleRenderSystem::InstanceGroup>& getDraws(int frameIndex) const {
+            return frames[frameIndex].draws;
+        }
+        VkBuffer getVisibleBuffer(int frameIndex) const { return frames[frameIndex].visibleBuffer->getBuffer(); }
+        VkBuffer getDrawBuffer(int frameIndex) const { return frames[frameIndex].drawBuffer->getBuffer(); }
+
+        // Visible instances per draw as counted by the GPU. Only valid once the command buffer that
+        // recorded the cull of frameIndex has finished.
+        std::vector<uint32_t> readVisibleCounts(int frameIndex) const;
+
+        // The same test on the CPU, for checking the GPU counts. Returns the visible instances per
+        // group of SimpleRenderSystem::groupInstances.
+        static std::vector<uint32_t> cullOnHost(
+            const std::vector<std::vector<LveGameObject>*>& objectLists, const LveCamera& camera);
+
+        // left, right, bottom, top, near and far planes as (normal, distance), normals pointing inwards
+        static std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& projectionView);
+        static bool isSphereVisible(const std::array<glm::vec4, 6>& planes, glm::vec3 center, float radius);
+
+    private:
+        struct FrameResources {
+            std::unique_ptr<LveBuffer> instanceBuffer;  // every instance, written by the host
+            std::unique_ptr<LveBuffer> visibleBuffer;   // the visible ones, compacted per model
+            std::unique_ptr<LveBuffer> drawBuffer;      // host visible so the counts can be read back
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            std::vector<SimpleRenderSystem::InstanceGroup> draws;
+        };
+
+        void createDescriptors();
+        void createPipelineLayout();
+        void createPipeline();
+        void reserve(FrameResources& frame, uint32_t instanceCount, uint32_t drawCount);
+
+        LveDevice& lveDevice;
+
+        std::unique_ptr<LveDescriptorPool> descriptorPool;
+        std::unique_ptr<LveDescriptorSetLayout> setLayout;
+        VkPipelineLayout pipelineLayout;
+        std::unique_ptr<LvePipeline> cullPipeline;
+
+        std::vector<FrameResources> frames;  // one per frame in flight
+    };
+}  // namespace lve
@@ -0,0 +1,303 @@
+#include "gpu_nbody_system.hpp"
+
+#include "lve_upload_manager.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+    struct NbodyStepPushConstantData {
+        uint32_t bodyCount;
+        float dt;
+        float accelerationScale;  // strengthGravity / unitScale^2, as in PhysicsSystem::kickBody
+        float unitScale;
+    };
+
+    // same layout as the push block of nbody_shader.vert
+    struct NbodyRenderPushConstantData {
+        glm::mat4 projectionView{ 1.f };
+        alignas(16) glm::vec3 color{};
+    };
+
+    GpuNbodySystem::GpuNbodySystem(LveDevice& device, VkRenderPass renderPass, float gravity, float scale)
+        : strengthGravity{ gravity }, unitScale{ scale }, lveDevice{ device } {
+        createDescriptors();
+        createPipelineLayouts();
+        createPipelines(renderPass);
+    }
+
+    GpuNbodySystem::~GpuNbodySystem() {
+        vkDestroyPipelineLayout(lveDevice.device(), stepPipelineLayout, nullptr);
+        vkDestroyPipelineLayout(lveDevice.device(), renderPipelineLayout, nullptr);
+    }
+
+    void GpuNbodySystem::createDescriptors() {
+        descriptorPool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(2)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8)
+            .build();
+        stepSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+    }
+
+    void GpuNbodySystem::createPipelineLayouts() {
+        VkPushConstantRange stepPushConstantRange{};
+        stepPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        stepPushConstantRange.offset = 0;
+        stepPushConstantRange.size = sizeof(NbodyStepPushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = stepSetLayout->getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo stepLayoutInfo{};
+        stepLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        stepLayoutInfo.setLayoutCount = 1;
+        stepLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        stepLayoutInfo.pushConstantRangeCount = 1;
+        stepLayoutInfo.pPushConstantRanges = &stepPushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &stepLayoutInfo, nullptr, &stepPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create n-body step pipeline layout!");
+        }
+
+        VkPushConstantRange renderPushConstantRange{};
+        renderPushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        renderPushConstantRange.offset = 0;
+        renderPushConstantRange.size = sizeof(NbodyRenderPushConstantData);
+
+        VkPipelineLayoutCreateInfo renderLayoutInfo{};
+        renderLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        renderLayoutInfo.setLayoutCount = 0;
+        renderLayoutInfo.pSetLayouts = nullptr;
+        renderLayoutInfo.pushConstantRangeCount = 1;
+        renderLayoutInfo.pPushConstantRanges = &renderPushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &renderLayoutInfo, nullptr, &renderPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create n-body render pipeline layout!");
+        }
+    }
+
+    void GpuNbodySystem::createPipelines(VkRenderPass renderPass) {
+        // binding 1 is the current position buffer, binding 2 the color and radius of each body
+        PipelineConfigInfo pipelineConfig{};
+        LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+        for (uint32_t binding = 1; binding <= 2; binding++) {
+            VkVertexInputBindingDescription bindingDescription{};
+            bindingDescription.binding = binding;
+            bindingDescription.stride = sizeof(glm::vec4);
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            pipelineConfig.bindingDescriptions.push_back(bindingDescription);
+
+            VkVertexInputAttributeDescription attributeDescription{};
+            attributeDescription.binding = binding;
+            attributeDescription.location = binding + 1;
+            attributeDescription.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attributeDescription.offset = 0;
+            pipelineConfig.attributeDescriptions.push_back(attributeDescription);
+        }
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = renderPipelineLayout;
+        LvePipeline::createInParallel({
+            [&] { stepPipeline = std::make_unique<LvePipeline>(lveDevice, "../nbody_step.comp.spv", stepPipelineLayout); },
+            [&] {
+                renderPipeline = std::make_unique<LvePipeline>(
+                    lveDevice,
+                    "../nbody_shader.vert.spv",
+                    "../simple_shader.frag.spv",
+                    pipelineConfig);
+            } });
+    }
+
+    void GpuNbodySystem::upload(const BodyStore& bodies) {
+        // the frames in flight may still read the buffers about to be replaced
+        vkDeviceWaitIdle(lveDevice.device());
+
+        bodyCount = static_cast<uint32_t>(bodies.size());
+        current = 0;
+        if (bodyCount == 0) return;
+
+        std::vector<glm::vec4> positions(bodyCount);
+        std::vector<glm::vec4> velocities(bodyCount);
+        std::vector<glm::vec4> properties(bodyCount);
+        for (uint32_t i = 0; i < bodyCount; i++) {
+            positions[i] = { bodies.x[i], bodies.y[i], bodies.z[i], bodies.mass[i] };
+            velocities[i] = { bodies.vx[i], bodies.vy[i], bodies.vz[i], 0.f };
+            properties[i] = { bodies.colorR[i], bodies.colorG[i], bodies.colorB[i], bodies.radius[i] };
+        }
+
+        auto createDeviceBuffer = [&](VkBufferUsageFlags usage) {
+            return std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(glm::vec4),
+                bodyCount,
+                usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        };
+        positionBuffers[0] = createDeviceBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        positionBuffers[1] = createDeviceBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        velocityBuffer = createDeviceBuffer(0);
+        propertyBuffer = createDeviceBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+        auto& uploadManager = lveDevice.getUploadManager();
+        const VkDeviceSize bufferSize = positionBuffers[0]->getBufferSize();
+        uploadManager.upload(positionBuffers[0]->getBuffer(), positions.data(), bufferSize);
+        uploadManager.upload(velocityBuffer->getBuffer(), velocities.data(), bufferSize);
+        uploadManager.wait(uploadManager.upload(propertyBuffer->getBuffer(), properties.data(), bufferSize));
+
+        for (uint32_t i = 0; i < 2; i++) {
+            auto positionsIn = positionBuffers[i]->descriptorInfo();
+            auto positionsOut = positionBuffers[1 - i]->descriptorInfo();
+            auto velocityInfo = velocityBuffer->descriptorInfo();
+            auto propertyInfo = propertyBuffer->descriptorInfo();
+            LveDescriptorWriter writer{ *stepSetLayout, *descriptorPool };
+            writer.writeBuffer(0, &positionsIn)
+                .writeBuffer(1, &positionsOut)
+                .writeBuffer(2, &velocityInfo)
+                .writeBuffer(3, &propertyInfo);
+            if (stepDescriptorSets[i] == VK_NULL_HANDLE) {
+                if (!writer.build(stepDescriptorSets[i])) {
+                    throw std::runtime_error("failed to allocate n-body descriptor set!");
+                }
+            }
+            else {
+                writer.overwrite(stepDescriptorSets[i]);
+            }
+        }
+    }
+
+    void GpuNbodySystem::download(BodyStore& bodies) {
+        assert(bodies.size() == bodyCount && "Bodies do not match the uploaded ones");
+        if (bodyCount == 0) return;
+        vkDeviceWaitIdle(lveDevice.device());
+
+        LveBuffer stagingBuffer{
+            lveDevice,
+            sizeof(glm::vec4),
+            bodyCount,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        stagingBuffer.map();
+        const auto* data = static_cast<const glm::vec4*>(stagingBuffer.getMappedMemory());
+
+        lveDevice.copyBuffer(positionBuffers[current]->getBuffer(), stagingBuffer.getBuffer(), stagingBuffer.getBufferSize());
+        for (uint32_t i = 0; i < bodyCount; i++) {
+            bodies.x[i] = data[i].x;
+            bodies.y[i] = data[i].y;
+            bodies.z[i] = data[i].z;
+        }
+
+        lveDevice.copyBuffer(velocityBuffer->getBuffer(), stagingBuffer.getBuffer(), stagingBuffer.getBufferSize());
+        for (uint32_t i = 0; i < bodyCount; i++) {
+            bodies.vx[i] = data[i].x;
+            bodies.vy[i] = data[i].y;
+            bodies.vz[i] = data[i].z;
+        }
+    }
+
+    void GpuNbodySystem::update(VkCommandBuffer commandBuffer, float dt, unsigned int substeps) {
+        if (bodyCount == 0 || substeps == 0) return;
+
+        // the previous frame's draw may still be reading the buffer the first substep writes,
+        // and the previous update's last dispatch wrote what the first substep reads
+        VkMemoryBarrier previousUpdate{};
+        previousUpdate.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        previousUpdate.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        previousUpdate.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            &previousUpdate,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        NbodyStepPushConstantData push{};
+        push.bodyCount = bodyCount;
+        push.dt = dt / substeps;
+        push.accelerationScale = strengthGravity / (unitScale * unitScale);
+        push.unitScale = unitScale;
+
+        stepPipeline->bind(commandBuffer);
+        vkCmdPushConstants(
+            commandBuffer,
+            stepPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(NbodyStepPushConstantData),
+            &push);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        for (unsigned int step = 0; step < substeps; step++) {
+            vkCmdBindDescriptorSets(
+                commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                stepPipelineLayout,
+                0,
+                1,
+                &stepDescriptorSets[current],
+                0,
+                nullptr);
+            vkCmdDispatch(commandBuffer, (bodyCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+            current = 1 - current;
+
+            // the next substep reads what this one wrote, the last one hands over to the draw
+            const bool last = step + 1 == substeps;
+            barrier.dstAccessMask = last
+                ? VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT
+                : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                last ? VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT
+                     : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                nullptr,
+                0,
+                nullptr);
+        }
+    }
+
+    void GpuNbodySystem::render(VkCommandBuffer commandBuffer, LveModel& model, const LveCamera& camera) {
+        if (bodyCount == 0) return;
+
+        renderPipeline->bind(commandBuffer);
+
+        NbodyRenderPushConstantData push{};
+        push.projectionView = camera.getProjection() * camera.getView();
+        vkCmdPushConstants(
+            commandBuffer,
+            renderPipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(NbodyRenderPushConstantData),
+            &push);
+
+        model.bind(commandBuffer);
+        VkBuffer buffers[] = { positionBuffers[current]->getBuffer(), propertyBuffer->getBuffer() };
+        VkDeviceSize offsets[] = { 0, 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 1, 2, buffers, offsets);
+        model.draw(commandBuffer, bodyCount);
+    }
+
+}  // namespace lve
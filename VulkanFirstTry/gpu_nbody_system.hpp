@@ -0,0 +1,74 @@
+#pragma once
+
+#include "body_store.hpp"
+#include "lve_buffer.hpp"
+#include "lve_camera.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+
+// std
+#include <memory>
+
+namespace lve {
+    // Direct-sum N-body on the GPU, the compute counterpart of PhysicsSystem's DirectSum solver with
+    // the SemiImplicitEuler integrator. Positions, velocities and colors live in device local storage
+    // buffers that the body pipeline reads as instance attributes, so a frame needs neither a
+    // readback nor a push constant per body. Bodies do not merge here: overlapping pairs exert no
+    // force on each other, as on the CPU, but stay separate.
+    //
+    // Only uses Vulkan 1.0 compute and the minimum limits, so it runs on any 1.1 device, lavapipe
+    // included.
+    class GpuNbodySystem {
+    public:
+        // local_size_x of nbody_step.comp and the size of its shared memory tile; 128 is the smallest
+        // maxComputeWorkGroupInvocations a device may report
+        static constexpr uint32_t WORKGROUP_SIZE = 128;
+
+        GpuNbodySystem(LveDevice& device, VkRenderPass renderPass, float gravity, float scale);
+        ~GpuNbodySystem();
+
+        GpuNbodySystem(const GpuNbodySystem&) = delete;
+        GpuNbodySystem& operator=(const GpuNbodySystem&) = delete;
+
+        const float strengthGravity;
+        const float unitScale;
+
+        // Replaces the simulated bodies, waiting for the queue to go idle. Only the float state is read.
+        void upload(const BodyStore& bodies);
+        // Copies positions and velocities back into bodies, which must still hold the uploaded bodies
+        // in the same order. Waits for the queue; meant for tests, not for every frame.
+        void download(BodyStore& bodies);
+
+        // Records substeps kicks and drifts of dt / substeps each, with the barriers against the
+        // previous frame's draw and for this frame's one. Must be recorded outside a render pass.
+        void update(VkCommandBuffer commandBuffer, float dt, unsigned int substeps = 1);
+        // draws every body as an instance of model, scaled by its radius
+        void render(VkCommandBuffer commandBuffer, LveModel& model, const LveCamera& camera);
+
+        uint32_t getBodyCount() const { return bodyCount; }
+
+    private:
+        void createDescriptors();
+        void createPipelineLayouts();
+        void createPipelines(VkRenderPass renderPass);
+
+        LveDevice& lveDevice;
+
+        std::unique_ptr<LveDescriptorPool> descriptorPool;
+        std::unique_ptr<LveDescriptorSetLayout> stepSetLayout;
+        VkPipelineLayout stepPipelineLayout;
+        VkPipelineLayout renderPipelineLayout;
+        std::unique_ptr<LvePipeline> stepPipeline;
+        std::unique_ptr<LvePipeline> renderPipeline;
+
+        // positions ping-pong between the two buffers, each substep reads one and writes the other
+        std::unique_ptr<LveBuffer> positionBuffers[2];  // xyz, mass
+        std::unique_ptr<LveBuffer> velocityBuffer;      // xyz, unused
+        std::unique_ptr<LveBuffer> propertyBuffer;      // color, radius
+        VkDescriptorSet stepDescriptorSets[2]{};        // [i] reads positionBuffers[i]
+        uint32_t current = 0;                           // buffer holding the latest positions
+        uint32_t bodyCount = 0;
+    };
+}  // namespace lve
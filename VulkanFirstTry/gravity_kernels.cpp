@@ -0,0 +1,264 @@
+#include "gravity_kernels.hpp"
+
+// std
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LVE_X86_KERNELS 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX instructions inside functions that opt in, MSVC always does
+#if defined(__GNUC__) || defined(__clang__)
+#define LVE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LVE_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define LVE_TARGET_AVX2
+#define LVE_TARGET_AVX512
+#endif
+
+namespace lve {
+
+    uint32_t directAccelerationScalar(
+        const GravitySources& sources, size_t begin, size_t end, float px, float py, float pz, float radius, float out[3]) {
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        uint32_t touching = 0;
+        for (size_t j = begin; j < end; j++) {
+            const float dx = sources.x[j] - px;
+            const float dy = sources.y[j] - py;
+            const float dz = sources.z[j] - pz;
+            const float r2 = dx * dx + dy * dy + dz * dz;
+            const float touch = radius + sources.radius[j];
+            if (r2 < touch * touch || r2 == 0.0f) {
+                touching++;
+                continue;
+            }
+            const float invR = 1.0f / std::sqrt(r2);
+            const float s = sources.mass[j] * invR * invR * invR;
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        out[0] = ax;
+        out[1] = ay;
+        out[2] = az;
+        return touching;
+    }
+
+    uint32_t directAccelerationDouble(
+        const GravitySourcesDouble& sources,
+        size_t begin,
+        size_t end,
+        double px, double py, double pz,
+        float radius,
+        double out[3]) {
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        uint32_t touching = 0;
+        for (size_t j = begin; j < end; j++) {
+            const double dx = sources.x[j] - px;
+            const double dy = sources.y[j] - py;
+            const double dz = sources.z[j] - pz;
+            const double r2 = dx * dx + dy * dy + dz * dz;
+            const double touch = static_cast<double>(radius) + sources.radius[j];
+            if (r2 < touch * touch || r2 == 0.0) {
+                touching++;
+                continue;
+            }
+            const double s = sources.mass[j] / (r2 * std::sqrt(r2));
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        out[0] = ax;
+        out[1] = ay;
+        out[2] = az;
+        return touching;
+    }
+
+#ifdef LVE_X86_KERNELS
+    static uint32_t countLanes(unsigned int mask) {
+        uint32_t count = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            count++;
+        }
+        return count;
+    }
+
+    LVE_TARGET_AVX2 static float horizontalSum(__m256 v) {
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+        return _mm_cvtss_f32(sum);
+    }
+
+    LVE_TARGET_AVX2 static uint32_t directAccelerationAvx2(
+        const GravitySources& sources, size_t begin, size_t end, float px, float py, float pz, float radius, float out[3]) {
+        const __m256 pxv = _mm256_set1_ps(px);
+        const __m256 pyv = _mm256_set1_ps(py);
+        const __m256 pzv = _mm256_set1_ps(pz);
+        const __m256 radiusv = _mm256_set1_ps(radius);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 threeHalves = _mm256_set1_ps(1.5f);
+        const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        __m256 ax = zero, ay = zero, az = zero;
+        uint32_t touching = 0;
+        for (size_t j = begin; j < end; j += 8) {
+            // the last block loads only the lanes that are still inside the range
+            const int remaining = static_cast<int>(end - j < 8 ? end - j : 8);
+            const __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), laneIndex);
+
+            const __m256 dx = _mm256_sub_ps(_mm256_maskload_ps(sources.x + j, active), pxv);
+            const __m256 dy = _mm256_sub_ps(_mm256_maskload_ps(sources.y + j, active), pyv);
+            const __m256 dz = _mm256_sub_ps(_mm256_maskload_ps(sources.z + j, active), pzv);
+            const __m256 m = _mm256_maskload_ps(sources.mass + j, active);
+            const __m256 touch = _mm256_add_ps(_mm256_maskload_ps(sources.radius + j, active), radiusv);
+
+            const __m256 r2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+            const __m256 pulls = _mm256_and_ps(
+                _mm256_and_ps(
+                    _mm256_cmp_ps(r2, _mm256_mul_ps(touch, touch), _CMP_GE_OQ),
+                    _mm256_cmp_ps(r2, zero, _CMP_GT_OQ)),
+                _mm256_castsi256_ps(active));
+            const int touchingLanes =
+                ~_mm256_movemask_ps(pulls) & _mm256_movemask_ps(_mm256_castsi256_ps(active));
+            touching += countLanes(static_cast<unsigned int>(touchingLanes));
+
+            // rsqrt is good to ~12 bits, one Newton step brings it close to full float precision
+            __m256 invR = _mm256_rsqrt_ps(r2);
+            invR = _mm256_mul_ps(
+                invR, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(invR, invR), threeHalves));
+            const __m256 s = _mm256_and_ps(_mm256_mul_ps(m, _mm256_mul_ps(invR, _mm256_mul_ps(invR, invR))), pulls);
+
+            ax = _mm256_fmadd_ps(s, dx, ax);
+            ay = _mm256_fmadd_ps(s, dy, ay);
+            az = _mm256_fmadd_ps(s, dz, az);
+        }
+        out[0] = horizontalSum(ax);
+        out[1] = horizontalSum(ay);
+        out[2] = horizontalSum(az);
+        return touching;
+    }
+
+    LVE_TARGET_AVX512 static float horizontalSum(__m512 v) {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, v);
+        float sum = 0.0f;
+        for (float lane : lanes) {
+            sum += lane;
+        }
+        return sum;
+    }
+
+    LVE_TARGET_AVX512 static uint32_t directAccelerationAvx512(
+        const GravitySources& sources, size_t begin, size_t end, float px, float py, float pz, float radius, float out[3]) {
+        const __m512 pxv = _mm512_set1_ps(px);
+        const __m512 pyv = _mm512_set1_ps(py);
+        const __m512 pzv = _mm512_set1_ps(pz);
+        const __m512 radiusv = _mm512_set1_ps(radius);
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 half = _mm512_set1_ps(0.5f);
+        const __m512 threeHalves = _mm512_set1_ps(1.5f);
+
+        __m512 ax = zero, ay = zero, az = zero;
+        uint32_t touching = 0;
+        for (size_t j = begin; j < end; j += 16) {
+            const size_t remaining = end - j < 16 ? end - j : 16;
+            const __mmask16 active = static_cast<__mmask16>((1u << remaining) - 1u);
+
+            const __m512 dx = _mm512_sub_ps(_mm512_maskz_loadu_ps(active, sources.x + j), pxv);
+            const __m512 dy = _mm512_sub_ps(_mm512_maskz_loadu_ps(active, sources.y + j), pyv);
+            const __m512 dz = _mm512_sub_ps(_mm512_maskz_loadu_ps(active, sources.z + j), pzv);
+            const __m512 m = _mm512_maskz_loadu_ps(active, sources.mass + j);
+            const __m512 touch = _mm512_add_ps(_mm512_maskz_loadu_ps(active, sources.radius + j), radiusv);
+
+            const __m512 r2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+            const __mmask16 pulls = _mm512_mask_cmp_ps_mask(
+                _mm512_mask_cmp_ps_mask(active, r2, _mm512_mul_ps(touch, touch), _CMP_GE_OQ), r2, zero, _CMP_GT_OQ);
+            touching += countLanes(static_cast<unsigned int>(active & ~pulls));
+
+            // rsqrt14 plus one Newton step
+            __m512 invR = _mm512_maskz_rsqrt14_ps(active, r2);
+            invR = _mm512_mul_ps(
+                invR, _mm512_fnmadd_ps(_mm512_mul_ps(half, r2), _mm512_mul_ps(invR, invR), threeHalves));
+            const __m512 s = _mm512_maskz_mul_ps(pulls, m, _mm512_mul_ps(invR, _mm512_mul_ps(invR, invR)));
+
+            ax = _mm512_fmadd_ps(s, dx, ax);
+            ay = _mm512_fmadd_ps(s, dy, ay);
+            az = _mm512_fmadd_ps(s, dz, az);
+        }
+        out[0] = horizontalSum(ax);
+        out[1] = horizontalSum(ay);
+        out[2] = horizontalSum(az);
+        return touching;
+    }
+
+    static bool osSupportsAvx(unsigned long long requiredStateMask) {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        return osxsave && (_xgetbv(0) & requiredStateMask) == requiredStateMask;
+#else
+        (void)requiredStateMask;
+        return true;  // __builtin_cpu_supports already checks the OS state
+#endif
+    }
+#endif
+
+    SimdLevel detectSimdLevel() {
+#ifdef LVE_X86_KERNELS
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+        const bool avx512f = (info[1] & (1 << 16)) != 0;
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        if (avx512f && avx2 && fma && osSupportsAvx(0xE6)) return SimdLevel::Avx512;
+        if (avx2 && fma && osSupportsAvx(0x6)) return SimdLevel::Avx2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+            osSupportsAvx(0xE6)) {
+            return SimdLevel::Avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && osSupportsAvx(0x6)) {
+            return SimdLevel::Avx2;
+        }
+#endif
+#endif
+        return SimdLevel::Scalar;
+    }
+
+    const char* simdLevelName(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::Avx512:
+            return "AVX-512";
+        case SimdLevel::Avx2:
+            return "AVX2";
+        default:
+            return "scalar";
+        }
+    }
+
+    DirectKernel selectDirectKernel(SimdLevel level) {
+#ifdef LVE_X86_KERNELS
+        static const SimdLevel supported = detectSimdLevel();
+        if (level == SimdLevel::Avx512 && supported == SimdLevel::Avx512) {
+            return directAccelerationAvx512;
+        }
+        if (level != SimdLevel::Scalar && supported != SimdLevel::Scalar) {
+            return directAccelerationAvx2;
+        }
+#else
+        (void)level;
+#endif
+        return directAccelerationScalar;
+    }
+
+}  // namespace lve
@@ -0,0 +1,60 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace lve {
+    enum class SimdLevel {
+        Scalar,
+        Avx2,    // 8 interactions per instruction
+        Avx512   // 16 interactions per instruction
+    };
+
+    // Source arrays the direct-sum kernels read, usually pointing into a BodyStore.
+    struct GravitySources {
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* mass;
+        const float* radius;
+    };
+
+    // Double precision positions for the full precision physics mode.
+    struct GravitySourcesDouble {
+        const double* x;
+        const double* y;
+        const double* z;
+        const float* mass;
+        const float* radius;
+    };
+
+    // Writes out = sum(m * (p_j - p) / |p_j - p|^3) over sources [begin, end), in
+    // scene units like BarnesHutTree. Sources closer than the summed radii (or at the target's exact
+    // position) exert no force; the kernel returns how many of them there were, so the target
+    // itself is counted when it is part of the range.
+    using DirectKernel = uint32_t (*)(
+        const GravitySources& sources,
+        size_t begin,
+        size_t end,
+        float px, float py, float pz,
+        float radius,
+        float out[3]);
+
+    // Highest level supported by both the build and the running CPU.
+    SimdLevel detectSimdLevel();
+    const char* simdLevelName(SimdLevel level);
+    // Falls back to the best supported lower level when `level` is unavailable.
+    DirectKernel selectDirectKernel(SimdLevel level);
+
+    uint32_t directAccelerationScalar(
+        const GravitySources& sources, size_t begin, size_t end, float px, float py, float pz, float radius, float out[3]);
+    // Same sum evaluated entirely in double.
+    uint32_t directAccelerationDouble(
+        const GravitySourcesDouble& sources,
+        size_t begin,
+        size_t end,
+        double px, double py, double pz,
+        float radius,
+        double out[3]);
+}  // namespace lve
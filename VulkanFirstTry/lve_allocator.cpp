@@ -0,0 +1,269 @@
+#include "lve_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    // smallest order whose range holds size bytes
+    static uint32_t orderFor(VkDeviceSize size) {
+        uint32_t order = 0;
+        while ((LveAllocator::MIN_ALLOCATION_SIZE << order) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    // *************** Memory Block *********************
+
+    LveMemoryBlock::LveMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void* mapped)
+        : memory{ memory }, size{ size }, mapped{ mapped } {
+        maxOrder = orderFor(size);
+        assert((LveAllocator::MIN_ALLOCATION_SIZE << maxOrder) == size && "Block size must be a power of two");
+        freeRanges.resize(maxOrder + 1);
+        freeRanges[maxOrder].insert(0);
+    }
+
+    bool LveMemoryBlock::allocate(uint32_t order, VkDeviceSize& offset) {
+        if (order > maxOrder) return false;
+
+        uint32_t current = order;
+        while (current <= maxOrder && freeRanges[current].empty()) {
+            current++;
+        }
+        if (current > maxOrder) return false;
+
+        offset = *freeRanges[current].begin();
+        freeRanges[current].erase(freeRanges[current].begin());
+        // split down to the requested size, keeping the lower half and freeing the upper one
+        while (current > order) {
+            current--;
+            freeRanges[current].insert(offset + (LveAllocator::MIN_ALLOCATION_SIZE << current));
+        }
+        usedBytes += LveAllocator::MIN_ALLOCATION_SIZE << order;
+        allocationCount++;
+        return true;
+    }
+
+    void LveMemoryBlock::free(VkDeviceSize offset, uint32_t order) {
+        usedBytes -= LveAllocator::MIN_ALLOCATION_SIZE << order;
+        allocationCount--;
+        while (order < maxOrder) {
+            const VkDeviceSize buddy = offset ^ (LveAllocator::MIN_ALLOCATION_SIZE << order);
+            auto it = freeRanges[order].find(buddy);
+            if (it == freeRanges[order].end()) break;
+            freeRanges[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        freeRanges[order].insert(offset);
+    }
+
+    VkDeviceSize LveMemoryBlock::largestFreeRange() const {
+        for (uint32_t order = maxOrder + 1; order-- > 0;) {
+            if (!freeRanges[order].empty()) return LveAllocator::MIN_ALLOCATION_SIZE << order;
+        }
+        return 0;
+    }
+
+    // *************** Allocator *********************
+
+    LveAllocator::LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : device{ device } {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+        pools.resize(memoryProperties.memoryTypeCount);
+    }
+
+    LveAllocator::~LveAllocator() {
+        assert(getStats().allocationCount == 0 && "Allocations outlive the allocator");
+        for (auto& typePools : pools) {
+            for (auto& pool : typePools) {
+                for (auto& block : pool.blocks) {
+                    vkFreeMemory(device, block->memory, nullptr);
+                }
+            }
+        }
+    }
+
+    // Small heaps, like the host visible window into VRAM on many discrete GPUs, get blocks of an
+    // eighth of the heap so one block cannot take all of it.
+    VkDeviceSize LveAllocator::blockSizeFor(uint32_t memoryType) const {
+        const VkDeviceSize heapSize =
+            memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        VkDeviceSize blockSize = PREFERRED_BLOCK_SIZE;
+        while (blockSize > MIN_ALLOCATION_SIZE && blockSize > heapSize / 8) {
+            blockSize /= 2;
+        }
+        return blockSize;
+    }
+
+    VkDeviceMemory LveAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+        deviceAllocations++;
+
+        *mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+        return memory;
+    }
+
+    LveAllocation LveAllocator::allocate(const VkMemoryRequirements& requirements, uint32_t memoryType, bool image) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        LveAllocation allocation{};
+        allocation.size = requirements.size;
+
+        const VkDeviceSize blockSize = blockSizeFor(memoryType);
+        if (std::max(requirements.size, requirements.alignment) > blockSize / 2) {
+            allocation.memory = allocateMemory(requirements.size, memoryType, &allocation.mapped);
+            dedicatedCount++;
+            dedicatedBytes += requirements.size;
+            return allocation;
+        }
+
+        allocation.order = orderFor(std::max(requirements.size, requirements.alignment));
+        Pool& pool = pools[memoryType][image ? 1 : 0];
+        LveMemoryBlock* block = nullptr;
+        for (auto& candidate : pool.blocks) {
+            if (candidate->allocate(allocation.order, allocation.offset)) {
+                block = candidate.get();
+                break;
+            }
+        }
+        if (block == nullptr) {
+            void* mapped;
+            VkDeviceMemory memory = allocateMemory(blockSize, memoryType, &mapped);
+            pool.blocks.push_back(std::make_unique<LveMemoryBlock>(memory, blockSize, mapped));
+            block = pool.blocks.back().get();
+            block->allocate(allocation.order, allocation.offset);
+        }
+        block->requestedBytes += requirements.size;
+
+        allocation.memory = block->memory;
+        allocation.block = block;
+        if (block->mapped != nullptr) {
+            allocation.mapped = static_cast<char*>(block->mapped) + allocation.offset;
+        }
+        return allocation;
+    }
+
+    void LveAllocator::free(LveAllocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE) return;
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        if (allocation.block == nullptr) {
+            vkFreeMemory(device, allocation.memory, nullptr);
+            dedicatedCount--;
+            dedicatedBytes -= allocation.size;
+            allocation = {};
+            return;
+        }
+
+        LveMemoryBlock* block = allocation.block;
+        block->free(allocation.offset, allocation.order);
+        block->requestedBytes -= allocation.size;
+        allocation = {};
+
+        // one empty block per pool is kept around so a scene reload does not allocate it again
+        if (!block->empty()) return;
+        for (auto& typePools : pools) {
+            for (auto& pool : typePools) {
+                auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const auto& candidate) {
+                    return candidate.get() == block;
+                });
+                if (it == pool.blocks.end()) continue;
+                const bool otherEmpty = std::any_of(pool.blocks.begin(), pool.blocks.end(), [&](const auto& candidate) {
+                    return candidate.get() != block && candidate->empty();
+                });
+                if (otherEmpty) {
+                    vkFreeMemory(device, block->memory, nullptr);
+                    pool.blocks.erase(it);
+                }
+                return;
+            }
+        }
+    }
+
+    VkMappedMemoryRange LveAllocator::mappedRange(
+        const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const {
+        if (size == VK_WHOLE_SIZE) {
+            size = allocation.size - offset;
+        }
+        const VkDeviceSize memorySize = allocation.block != nullptr ? allocation.block->size : allocation.size;
+        const VkDeviceSize begin = (allocation.offset + offset) / nonCoherentAtomSize * nonCoherentAtomSize;
+        VkDeviceSize end = allocation.offset + offset + size;
+        end = (end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        // a dedicated allocation need not be a multiple of the atom size, its end is always fine
+        range.size = end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+        return range;
+    }
+
+    VkResult LveAllocator::flush(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkFlushMappedMemoryRanges(device, 1, &range);
+    }
+
+    VkResult LveAllocator::invalidate(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkInvalidateMappedMemoryRanges(device, 1, &range);
+    }
+
+    LveAllocatorStats LveAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock{ mutex };
+        LveAllocatorStats stats{};
+        stats.dedicatedCount = dedicatedCount;
+        stats.allocationCount = dedicatedCount;
+        stats.deviceAllocations = deviceAllocations;
+        stats.reservedBytes = dedicatedBytes;
+        stats.usedBytes = dedicatedBytes;
+        stats.requestedBytes = dedicatedBytes;
+        for (const auto& typePools : pools) {
+            for (const auto& pool : typePools) {
+                for (const auto& block : pool.blocks) {
+                    stats.blockCount++;
+                    stats.allocationCount += block->allocationCount;
+                    stats.reservedBytes += block->size;
+                    stats.usedBytes += block->usedBytes;
+                    stats.requestedBytes += block->requestedBytes;
+                    stats.largestFreeRange = std::max(stats.largestFreeRange, block->largestFreeRange());
+                }
+            }
+        }
+        return stats;
+    }
+
+    float LveAllocatorStats::externalFragmentation() const {
+        const VkDeviceSize freeBytes = reservedBytes - usedBytes;
+        return freeBytes > 0 ? 1.f - static_cast<float>(largestFreeRange) / freeBytes : 0.f;
+    }
+
+    void printAllocatorStats(const LveAllocatorStats& stats, std::ostream& out) {
+        out << "device memory: " << stats.allocationCount << " allocations in " << stats.blockCount << " blocks + "
+            << stats.dedicatedCount << " dedicated, " << stats.deviceAllocations << " vkAllocateMemory calls\n"
+            << "  " << stats.requestedBytes << " bytes requested, " << stats.usedBytes << " used, "
+            << stats.reservedBytes << " reserved, largest free range " << stats.largestFreeRange << "\n"
+            << "  fragmentation: " << stats.internalFragmentation() * 100.f << "% internal, "
+            << stats.externalFragmentation() * 100.f << "% external\n";
+    }
+
+}  // namespace lve
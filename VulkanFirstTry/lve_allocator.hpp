@@ -0,0 +1,128 @@
+#pragma once
+
+// libs
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+    class LveMemoryBlock;
+
+    // A range of device memory handed out by LveAllocator. Host visible memory stays mapped for the
+    // lifetime of its block, mapped points at offset.
+    struct LveAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;  // as requested
+        void* mapped = nullptr;
+
+        LveMemoryBlock* block = nullptr;  // nullptr for a dedicated allocation
+        uint32_t order = 0;               // buddy order within block
+    };
+
+    struct LveAllocatorStats {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedCount = 0;     // allocations too large for a block
+        uint32_t allocationCount = 0;    // live ones, dedicated included
+        uint64_t deviceAllocations = 0;  // vkAllocateMemory calls since creation
+        VkDeviceSize reservedBytes = 0;  // held in VkDeviceMemory objects
+        VkDeviceSize usedBytes = 0;      // handed out, rounded up to the buddy sizes
+        VkDeviceSize requestedBytes = 0;
+        VkDeviceSize largestFreeRange = 0;
+
+        // share of the used bytes lost to rounding up to a power of two
+        float internalFragmentation() const {
+            return usedBytes > 0 ? 1.f - static_cast<float>(requestedBytes) / usedBytes : 0.f;
+        }
+        // share of the free block memory that is not in the largest free range
+        float externalFragmentation() const;
+    };
+
+    void printAllocatorStats(const LveAllocatorStats& stats, std::ostream& out);
+
+    // Sub-allocates buffers and images out of large VkDeviceMemory blocks instead of calling
+    // vkAllocateMemory for every resource, which is slow and capped by maxMemoryAllocationCount.
+    //
+    // Every memory type has one pool for buffers and one for optimal tiling images, so the two never
+    // share a block and bufferImageGranularity cannot bite. Blocks are buddy allocators: the size
+    // classes are the powers of two from MIN_ALLOCATION_SIZE up to the block size, each with its own
+    // free list, and a freed range merges with its buddy right away. Since a range is aligned to its
+    // own size, rounding the request up to the alignment is all the alignment handling needed.
+    // Requests over half a block get a dedicated allocation.
+    class LveAllocator {
+    public:
+        static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;  // also the largest nonCoherentAtomSize
+        static constexpr VkDeviceSize PREFERRED_BLOCK_SIZE = 64 * 1024 * 1024;
+
+        LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+        ~LveAllocator();
+
+        LveAllocator(const LveAllocator&) = delete;
+        LveAllocator& operator=(const LveAllocator&) = delete;
+
+        // thread safe, throws when the memory type is exhausted
+        LveAllocation allocate(const VkMemoryRequirements& requirements, uint32_t memoryType, bool image);
+        void free(LveAllocation& allocation);
+
+        // Flush and invalidate a range of the allocation, VK_WHOLE_SIZE up to its end, widened to
+        // nonCoherentAtomSize. Only needed for memory that is not host coherent.
+        VkResult flush(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+        VkResult invalidate(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+        LveAllocatorStats getStats() const;
+
+    private:
+        struct Pool {
+            std::vector<std::unique_ptr<LveMemoryBlock>> blocks;
+        };
+
+        VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+        VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped);
+        VkMappedMemoryRange mappedRange(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+
+        mutable std::mutex mutex;
+        std::vector<std::array<Pool, 2>> pools;  // per memory type: buffers, images
+        uint32_t dedicatedCount = 0;
+        VkDeviceSize dedicatedBytes = 0;
+        uint64_t deviceAllocations = 0;
+    };
+
+    // One VkDeviceMemory split by a buddy allocator.
+    class LveMemoryBlock {
+    public:
+        LveMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void* mapped);
+
+        // offset of a free range of MIN_ALLOCATION_SIZE << order, or false when there is none
+        bool allocate(uint32_t order, VkDeviceSize& offset);
+        void free(VkDeviceSize offset, uint32_t order);
+
+        bool empty() const { return usedBytes == 0; }
+        VkDeviceSize largestFreeRange() const;
+
+        const VkDeviceMemory memory;
+        const VkDeviceSize size;
+        void* const mapped;  // nullptr unless host visible
+        VkDeviceSize usedBytes = 0;
+        VkDeviceSize requestedBytes = 0;
+        uint32_t allocationCount = 0;
+
+    private:
+        uint32_t maxOrder;
+        std::vector<std::set<VkDeviceSize>> freeRanges;  // offsets per order
+    };
+
+}  // namespace lve
@@ -0,0 +1,98 @@
+#include "lve_buffer.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+
+namespace lve {
+
+    // rounds instanceSize up to a multiple of minOffsetAlignment, which Vulkan guarantees is a
+    // power of two (minUniformBufferOffsetAlignment, nonCoherentAtomSize, ...)
+    VkDeviceSize LveBuffer::getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
+        if (minOffsetAlignment > 0) {
+            return (instanceSize + minOffsetAlignment - 1) & ~(minOffsetAlignment - 1);
+        }
+        return instanceSize;
+    }
+
+    LveBuffer::LveBuffer(
+        LveDevice& device,
+        VkDeviceSize instanceSize,
+        uint32_t instanceCount,
+        VkBufferUsageFlags usageFlags,
+        VkMemoryPropertyFlags memoryPropertyFlags,
+        VkDeviceSize minOffsetAlignment)
+        : lveDevice{ device },
+        instanceCount{ instanceCount },
+        instanceSize{ instanceSize },
+        usageFlags{ usageFlags },
+        memoryPropertyFlags{ memoryPropertyFlags } {
+        alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
+        bufferSize = alignmentSize * instanceCount;
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+    }
+
+    LveBuffer::~LveBuffer() {
+        unmap();
+        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+        lveDevice.freeMemory(memory);
+    }
+
+    // Points getMappedMemory() at offset in the buffer's memory. The memory must be host visible;
+    // the allocator keeps its blocks mapped, so neither this nor unmap() calls into the driver.
+    VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
+        assert(buffer && memory.memory && "Called map on buffer before create");
+        assert(offset <= bufferSize && (size == VK_WHOLE_SIZE || size <= bufferSize - offset) &&
+            "Mapped range must lie inside the buffer");
+        (void)size;  // the whole block is mapped anyway, size is only checked
+        if (memory.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(memory.mapped) + offset;
+        return VK_SUCCESS;
+    }
+
+    void LveBuffer::unmap() {
+        mapped = nullptr;
+    }
+
+    // Copies size bytes of data to offset in the mapped range, or the whole buffer when size is
+    // VK_WHOLE_SIZE. Non-coherent memory still needs a flush() afterwards.
+    void LveBuffer::writeToBuffer(const void* data, VkDeviceSize size, VkDeviceSize offset) {
+        assert(mapped && "Cannot copy to unmapped buffer");
+
+        if (size == VK_WHOLE_SIZE) {
+            memcpy(mapped, data, bufferSize);
+        }
+        else {
+            char* memOffset = static_cast<char*>(mapped);
+            memOffset += offset;
+            memcpy(memOffset, data, size);
+        }
+    }
+
+    // makes host writes to non-coherent memory visible to the device
+    VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
+        return lveDevice.getAllocator().flush(memory, size, offset);
+    }
+
+    // makes device writes to non-coherent memory visible to the host
+    VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
+        return lveDevice.getAllocator().invalidate(memory, size, offset);
+    }
+
+    VkDescriptorBufferInfo LveBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) {
+        return VkDescriptorBufferInfo{ buffer, offset, size };
+    }
+
+    void LveBuffer::writeToIndex(const void* data, int index) {
+        writeToBuffer(data, instanceSize, index * alignmentSize);
+    }
+
+    VkResult LveBuffer::flushIndex(int index) { return flush(alignmentSize, index * alignmentSize); }
+
+    VkDescriptorBufferInfo LveBuffer::descriptorInfoForIndex(int index) {
+        return descriptorInfo(alignmentSize, index * alignmentSize);
+    }
+
+}  // namespace lve
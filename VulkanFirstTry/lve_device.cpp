@@ -1,8 +1,13 @@
 #include "lve_device.hpp"
 
+#include "lve_upload_manager.hpp"
+
 // std headers
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <random>
 #include <set>
 #include <unordered_set>
 
@@ -48,16 +53,35 @@ namespace lve {
     }
 
     // class member functions
-    LveDevice::LveDevice(LveWindow& window) : window{ window } {
+    LveDevice::LveDevice(LveWindow& window) : window{ &window } {
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
+        allocator = std::make_unique<LveAllocator>(physicalDevice, device_);
+        uploadManager = std::make_unique<LveUploadManager>(*this);
+    }
+
+    LveDevice::LveDevice() {
+        createInstance();
+        setupDebugMessenger();
+        pickPhysicalDevice();
+        createLogicalDevice();
+        createCommandPool();
+        createPipelineCache();
+        allocator = std::make_unique<LveAllocator>(physicalDevice, device_);
+        uploadManager = std::make_unique<LveUploadManager>(*this);
     }
 
     LveDevice::~LveDevice() {
+        uploadManager.reset();
+        allocator.reset();
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -65,7 +89,9 @@ namespace lve {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -137,9 +163,11 @@ namespace lve {
 
     void LveDevice::createLogicalDevice() {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+        physicalQueueFamilies = indices;
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = {
+            indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -180,6 +208,7 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
     }
 
     void LveDevice::createCommandPool() {
@@ -196,15 +225,86 @@ namespace lve {
         }
     }
 
-    void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void LveDevice::createPipelineCache() {
+        std::vector<char> initialData;
+        std::ifstream file{ PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary };
+        if (file.is_open()) {
+            initialData.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(initialData.data(), initialData.size());
+            if (!file || !isPipelineCacheCompatible(initialData)) {
+                std::cout << "pipeline cache: ignoring " << PIPELINE_CACHE_PATH << ", made by another driver or GPU"
+                          << std::endl;
+                initialData.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+        loadedPipelineCacheSize = initialData.size();
+        std::cout << "pipeline cache: " << loadedPipelineCacheSize << " bytes loaded" << std::endl;
+    }
+
+    // Drivers are meant to reject a foreign cache themselves, but not all of them do it gracefully.
+    // The header is the one of VK_PIPELINE_CACHE_HEADER_VERSION_ONE: header size, version, vendor
+    // id, device id and the pipeline cache UUID, which changes with the driver build.
+    bool LveDevice::isPipelineCacheCompatible(const std::vector<char>& data) const {
+        constexpr size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+        if (data.size() < headerSize) return false;
+
+        uint32_t header[4];
+        memcpy(header, data.data(), sizeof(header));
+        return header[0] >= headerSize && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header[2] == properties.vendorID && header[3] == properties.deviceID &&
+            memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    // Written to a file of its own and renamed over the old one, so the many short runs sharing a
+    // working directory never read a half written cache.
+    void LveDevice::savePipelineCache() {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr) != VK_SUCCESS ||
+            dataSize == loadedPipelineCacheSize) {
+            return;
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, data.data()) != VK_SUCCESS) {
+            return;
+        }
+
+        const std::string tempPath =
+            std::string{ PIPELINE_CACHE_PATH } + ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(data.data(), dataSize);
+            if (!file) {
+                std::cerr << "pipeline cache: failed to write " << tempPath << std::endl;
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+        if (error) {
+            std::cerr << "pipeline cache: failed to replace " << PIPELINE_CACHE_PATH << ": " << error.message()
+                      << std::endl;
+            std::filesystem::remove(tempPath, error);
+        }
+    }
+
+    void LveDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -264,11 +364,13 @@ namespace lve {
     }
 
     std::vector<const char*> LveDevice::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions;
+        if (!isHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -331,12 +433,20 @@ namespace lve {
 
         int i = 0;
         for (const auto& queueFamily : queueFamilies) {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            // compute work is submitted to the graphics queue, so it has to support both
+            const VkQueueFlags graphicsAndCompute = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+            if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & graphicsAndCompute) == graphicsAndCompute) {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // nothing is presented headless, the graphics queue stands in
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless()) {
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -348,6 +458,17 @@ namespace lve {
             i++;
         }
 
+        // a family without graphics is usually a DMA engine that copies alongside the rendering
+        indices.transferFamily = indices.graphicsFamily;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            const VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+                !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+                indices.transferFamily = family;
+                if (!(flags & VK_QUEUE_COMPUTE_BIT)) break;
+            }
+        }
+
         return indices;
     }
 
@@ -412,13 +533,23 @@ namespace lve {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) {
+        LveAllocation& bufferMemory) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+        // concurrent sharing spares the uploads a queue family ownership transfer
+        const uint32_t graphicsFamily = physicalQueueFamilies.graphicsFamily;
+        const uint32_t transferFamily = physicalQueueFamilies.transferFamily;
+        const uint32_t sharedFamilies[] = { graphicsFamily, transferFamily };
+        if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && transferFamily != graphicsFamily) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = sharedFamilies;
+        }
+
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to create vertex buffer!");
         }
@@ -426,16 +557,9 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        bufferMemory = allocator->allocate(
+            memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties), false);
+        vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
     }
 
     VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -513,7 +637,7 @@ namespace lve {
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory) {
+        LveAllocation& imageMemory) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
@@ -521,16 +645,9 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        imageMemory = allocator->allocate(
+            memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties), true);
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
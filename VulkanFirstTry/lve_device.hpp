@@ -1,13 +1,17 @@
 #pragma once
 
+#include "lve_allocator.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+    class LveUploadManager;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -17,6 +21,7 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;  // a transfer only family if there is one, else the graphics family
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -30,7 +35,15 @@ namespace lve {
         const bool enableValidationLayers = true;
 #endif
 
+        // Pipeline cache file, relative to the working directory like the shaders. Loaded at startup
+        // when it comes from this driver and GPU, written back on destruction when it has grown.
+        static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
         LveDevice(LveWindow& window);
+        // Headless: no surface and no swap chain extension, so any device with a graphics and
+        // compute queue will do, lavapipe included. GLFW is not touched. Render with
+        // LveOffscreenRenderer then.
+        LveDevice();
         ~LveDevice();
 
         // Not copyable or movable
@@ -41,9 +54,13 @@ namespace lve {
 
         VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
-        VkSurfaceKHR surface() { return surface_; }
-        VkQueue graphicsQueue() { return graphicsQueue_; }
+        VkSurfaceKHR surface() { return surface_; }  // VK_NULL_HANDLE when headless
+        bool isHeadless() const { return window == nullptr; }
+        VkQueue graphicsQueue() { return graphicsQueue_; }  // also takes the compute passes
         VkQueue presentQueue() { return presentQueue_; }
+        VkQueue transferQueue() { return transferQueue_; }  // only used by the upload manager
+        // internally synchronized, pipelines may be created with it from any thread
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -52,12 +69,18 @@ namespace lve {
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         // Buffer Helper Functions
+        // The memory is sub-allocated from the allocator, release it with freeMemory. Buffers that can
+        // be a transfer destination are shared with the transfer queue family.
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            LveAllocation& bufferMemory);
+        void freeMemory(LveAllocation& memory) { allocator->free(memory); }
+        LveAllocator& getAllocator() { return *allocator; }
+        // batches staging uploads into device local buffers, see LveUploadManager
+        LveUploadManager& getUploadManager() { return *uploadManager; }
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -68,7 +91,7 @@ namespace lve {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            LveAllocation& imageMemory);
 
         VkPhysicalDeviceProperties properties;
 
@@ -79,6 +102,8 @@ namespace lve {
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createPipelineCache();
+        void savePipelineCache();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,21 +113,29 @@ namespace lve {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        // whether data starts with the cache header of this driver and GPU
+        bool isPipelineCacheCompatible(const std::vector<char>& data) const;
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        LveWindow& window;
+        LveWindow* window = nullptr;
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+        size_t loadedPipelineCacheSize = 0;
+        QueueFamilyIndices physicalQueueFamilies;  // cached for createBuffer
+        std::unique_ptr<LveAllocator> allocator;
+        std::unique_ptr<LveUploadManager> uploadManager;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-        const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> deviceExtensions;  // the swap chain one unless headless
     };
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "lve_camera.hpp"
+
+// lib
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+namespace lve {
+
+    // set 0, binding 0 of every pipeline drawing in world space, one buffer per frame in flight
+    struct GlobalUbo {
+        glm::mat4 projectionView{ 1.f };
+        glm::mat4 projection{ 1.f };
+        glm::mat4 view{ 1.f };
+    };
+
+    struct FrameInfo {
+        int frameIndex;
+        float frameTime;
+        VkCommandBuffer commandBuffer;
+        LveCamera& camera;
+        VkDescriptorSet globalDescriptorSet;  // holds the GlobalUbo of frameIndex
+    };
+
+}  // namespace lve
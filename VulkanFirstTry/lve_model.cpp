@@ -1,8 +1,12 @@
 #include "lve_model.hpp"
 
+#include "lve_upload_manager.hpp"
+
 // std
 #include <cassert>
 #include <cstring>
+#include <functional>
+#include <unordered_map>
 
 namespace lve {
 
@@ -10,36 +14,122 @@ namespace lve {
         createVertexBuffers(vertices);
     }
 
+    LveModel::LveModel(LveDevice& device, const Builder& builder) : lveDevice{ device } {
+        createVertexBuffers(builder.vertices);
+        createIndexBuffers(builder.indices);
+    }
+
     LveModel::~LveModel() {
+        if (uploadTicket != 0) {
+            lveDevice.getUploadManager().wait(uploadTicket);
+        }
         vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-        vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr);
+        lveDevice.freeMemory(vertexBufferMemory);
+        if (hasIndexBuffer()) {
+            vkDestroyBuffer(lveDevice.device(), indexBuffer, nullptr);
+            lveDevice.freeMemory(indexBufferMemory);
+        }
     }
 
     void LveModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
         vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount >= 3 && "Vertex count must be at least 3");
+        // a single vertex is a point model, only drawn by point list pipelines
+        assert(vertexCount >= 1 && "Vertex count must be at least 1");
+        for (const auto& vertex : vertices) {
+            boundingRadius = glm::max(boundingRadius, glm::length(vertex.position));
+        }
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
         lveDevice.createBuffer(
             bufferSize,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             vertexBuffer,
             vertexBufferMemory);
 
-        void* data;
-        vkMapMemory(lveDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
+        // batched with the other models loaded before the first bind
+        uploadTicket = lveDevice.getUploadManager().upload(vertexBuffer, vertices.data(), bufferSize);
+    }
+
+    void LveModel::createIndexBuffers(const std::vector<uint32_t>& indices) {
+        indexCount = static_cast<uint32_t>(indices.size());
+        if (indexCount == 0) return;
+        assert(indexCount % 3 == 0 && "Index count must be a multiple of 3");
+
+        // 0xFFFF is the primitive restart index, so 16 bits hold up to 65535 vertices
+        std::vector<uint16_t> shortIndices;
+        const void* data = indices.data();
+        VkDeviceSize bufferSize = sizeof(uint32_t) * indexCount;
+        if (vertexCount <= 0xFFFF) {
+            shortIndices.assign(indices.begin(), indices.end());
+            indexType = VK_INDEX_TYPE_UINT16;
+            data = shortIndices.data();
+            bufferSize = sizeof(uint16_t) * indexCount;
+        }
+        else {
+            indexType = VK_INDEX_TYPE_UINT32;
+        }
+
+        lveDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            indexBuffer,
+            indexBufferMemory);
+        uploadTicket = lveDevice.getUploadManager().upload(indexBuffer, data, bufferSize);
     }
 
-    void LveModel::draw(VkCommandBuffer commandBuffer) {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+    void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+        if (hasIndexBuffer()) {
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+        }
+        else {
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+        }
     }
 
     void LveModel::bind(VkCommandBuffer commandBuffer) {
+        const uint64_t ticket = uploadTicket.load(std::memory_order_acquire);
+        if (ticket != 0) {
+            lveDevice.getUploadManager().wait(ticket);
+            uploadTicket.store(0, std::memory_order_release);
+        }
         VkBuffer buffers[] = { vertexBuffer };
         VkDeviceSize offsets[] = { 0 };
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        if (hasIndexBuffer()) {
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+        }
+    }
+
+    // Hashes the bytes of the vertex, with -0 folded into 0 first so that equal vertices hash
+    // equally.
+    struct VertexHash {
+        size_t operator()(const LveModel::Vertex& vertex) const {
+            const float components[] = {
+                vertex.position.x + 0.f, vertex.position.y + 0.f, vertex.position.z + 0.f,
+                vertex.color.r + 0.f, vertex.color.g + 0.f, vertex.color.b + 0.f };
+            size_t seed = 0;
+            for (float component : components) {
+                uint32_t bits;
+                memcpy(&bits, &component, sizeof(bits));
+                seed ^= std::hash<uint32_t>{}(bits) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    LveModel::Builder LveModel::Builder::weld(const std::vector<Vertex>& triangleVertices) {
+        Builder builder{};
+        builder.indices.reserve(triangleVertices.size());
+        std::unordered_map<Vertex, uint32_t, VertexHash> uniqueVertices{};
+        for (const auto& vertex : triangleVertices) {
+            auto inserted = uniqueVertices.emplace(vertex, static_cast<uint32_t>(builder.vertices.size()));
+            if (inserted.second) {
+                builder.vertices.push_back(vertex);
+            }
+            builder.indices.push_back(inserted.first->second);
+        }
+        return builder;
     }
 
     std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions() {
@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 
 // std
+#include <atomic>
 #include <vector>
 
 namespace lve {
@@ -19,23 +20,60 @@ namespace lve {
 
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+            bool operator==(const Vertex& other) const {
+                return position == other.position && color == other.color;
+            }
+        };
+
+        // Vertices with an optional triangle list of indices into them. Stored as 16-bit indices
+        // when every vertex fits, 32-bit otherwise.
+        struct Builder {
+            std::vector<Vertex> vertices{};
+            std::vector<uint32_t> indices{};
+
+            // Merges the identical vertices of a triangle list, as procedural meshes emit them once
+            // per triangle, and indexes the rest.
+            static Builder weld(const std::vector<Vertex>& triangleVertices);
         };
 
         LveModel(LveDevice& device, const std::vector<Vertex>& vertices);
+        LveModel(LveDevice& device, const Builder& builder);
         ~LveModel();
 
         LveModel(const LveModel&) = delete;
         LveModel& operator=(const LveModel&) = delete;
 
+        uint32_t getVertexCount() const { return vertexCount; }
+        bool hasIndexBuffer() const { return indexCount > 0; }
+        uint32_t getIndexCount() const { return indexCount; }
+        // what a draw of one instance covers: indices if there are any, else vertices
+        uint32_t getDrawCount() const { return hasIndexBuffer() ? indexCount : vertexCount; }
+        // distance of the farthest vertex from the model origin, for culling
+        float getBoundingRadius() const { return boundingRadius; }
+
         void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        // draws instanceCount copies; the instanced pipeline reads their per-instance data starting at
+        // firstInstance in the buffer bound to binding 1
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
 
     private:
         void createVertexBuffers(const std::vector<Vertex>& vertices);
+        void createIndexBuffers(const std::vector<uint32_t>& indices);
 
         LveDevice& lveDevice;
         VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
+        LveAllocation vertexBufferMemory;
+        // of the vertices and indices, waited for on the first bind, which may come from several
+        // recording threads at once
+        std::atomic<uint64_t> uploadTicket{ 0 };
         uint32_t vertexCount;
+
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        LveAllocation indexBufferMemory{};
+        VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+        uint32_t indexCount = 0;
+
+        float boundingRadius{ 0.f };
     };
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "lve_offscreen_renderer.hpp"
+
+// std
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+    LveOffscreenRenderer::LveOffscreenRenderer(LveDevice& device, VkExtent2D extent, FrameCallback onFrame)
+        : lveDevice{ device }, extent{ extent }, onFrame{ std::move(onFrame) } {
+        depthFormat = lveDevice.findSupportedFormat(
+            { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        createRenderPass();
+        for (auto& slot : slots) {
+            createFrameSlot(slot);
+        }
+    }
+
+    LveOffscreenRenderer::~LveOffscreenRenderer() {
+        for (auto& slot : slots) {
+            if (slot.pending) {
+                vkWaitForFences(lveDevice.device(), 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            }
+            vkDestroyFence(lveDevice.device(), slot.fence, nullptr);
+            vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), 1, &slot.commandBuffer);
+            slot.readbackBuffer.reset();
+            vkDestroyFramebuffer(lveDevice.device(), slot.framebuffer, nullptr);
+            vkDestroyImageView(lveDevice.device(), slot.depthView, nullptr);
+            vkDestroyImage(lveDevice.device(), slot.depthImage, nullptr);
+            lveDevice.freeMemory(slot.depthMemory);
+            vkDestroyImageView(lveDevice.device(), slot.colorView, nullptr);
+            vkDestroyImage(lveDevice.device(), slot.colorImage, nullptr);
+            lveDevice.freeMemory(slot.colorMemory);
+        }
+        vkDestroyRenderPass(lveDevice.device(), renderPass, nullptr);
+    }
+
+    // The swap chain's pass, except that the color image ends up ready for the copy to the host.
+    void LveOffscreenRenderer::createRenderPass() {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = COLOR_FORMAT;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = depthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorAttachmentRef{};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference depthAttachmentRef{};
+        depthAttachmentRef.attachment = 1;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+        std::array<VkSubpassDependency, 2> dependencies{};
+        // the previous frame of the slot was copied out before it is cleared again
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask =
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        // and the copy waits for the color writes
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen render pass!");
+        }
+    }
+
+    void LveOffscreenRenderer::createImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+        VkImage& image, LveAllocation& memory, VkImageView& view) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = aspect;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image view!");
+        }
+    }
+
+    void LveOffscreenRenderer::createFrameSlot(FrameSlot& slot) {
+        createImage(
+            COLOR_FORMAT,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            slot.colorImage,
+            slot.colorMemory,
+            slot.colorView);
+        createImage(
+            depthFormat,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            VK_IMAGE_ASPECT_DEPTH_BIT,
+            slot.depthImage,
+            slot.depthMemory,
+            slot.depthView);
+
+        std::array<VkImageView, 2> attachments = { slot.colorView, slot.depthView };
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &slot.framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen framebuffer!");
+        }
+
+        // cached memory makes the host reads fast; host visible coherent memory is always there
+        VkMemoryPropertyFlags readbackProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        try {
+            lveDevice.findMemoryType(std::numeric_limits<uint32_t>::max(), readbackProperties);
+        }
+        catch (const std::runtime_error&) {
+            readbackProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        }
+        slot.readbackBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            4,
+            extent.width * extent.height,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            readbackProperties);
+        slot.readbackBuffer->map();
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = lveDevice.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &slot.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate offscreen command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen fence!");
+        }
+    }
+
+    void LveOffscreenRenderer::retire(FrameSlot& slot) {
+        if (!slot.pending) return;
+
+        const auto waitStart = std::chrono::steady_clock::now();
+        vkWaitForFences(lveDevice.device(), 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        readbackWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+        vkResetFences(lveDevice.device(), 1, &slot.fence);
+        slot.pending = false;
+
+        framesRead++;
+        if (onFrame) {
+            onFrame(slot.frameNumber, static_cast<const uint8_t*>(slot.readbackBuffer->getMappedMemory()));
+        }
+    }
+
+    VkCommandBuffer LveOffscreenRenderer::beginFrame() {
+        assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        FrameSlot& slot = slots[currentFrameIndex];
+        retire(slot);
+
+        isFrameStarted = true;
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+        return slot.commandBuffer;
+    }
+
+    void LveOffscreenRenderer::endFrame() {
+        assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+        FrameSlot& slot = slots[currentFrameIndex];
+
+        // bufferRowLength 0 packs the rows tightly
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { extent.width, extent.height, 1 };
+        vkCmdCopyImageToBuffer(
+            slot.commandBuffer,
+            slot.colorImage,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            slot.readbackBuffer->getBuffer(),
+            1,
+            &region);
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = slot.readbackBuffer->getBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            slot.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &barrier,
+            0,
+            nullptr);
+
+        if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &slot.commandBuffer;
+        if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, slot.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit offscreen command buffer!");
+        }
+        slot.pending = true;
+        slot.frameNumber = nextFrameNumber++;
+
+        isFrameStarted = false;
+        currentFrameIndex = (currentFrameIndex + 1) % FRAMES_IN_FLIGHT;
+    }
+
+    void LveOffscreenRenderer::beginRenderPass(VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't call beginRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == slots[currentFrameIndex].commandBuffer &&
+            "Can't begin render pass on command buffer from a different frame");
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = slots[currentFrameIndex].framebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = extent;
+
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+        clearValues[1].depthStencil = { 1.0f, 0 };
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ { 0, 0 }, extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    void LveOffscreenRenderer::endRenderPass(VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't call endRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == slots[currentFrameIndex].commandBuffer &&
+            "Can't end render pass on command buffer from a different frame");
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    void LveOffscreenRenderer::finish() {
+        assert(!isFrameStarted && "Can't finish while a frame is in progress");
+        // the slot about to be reused holds the oldest frame
+        for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+            retire(slots[(currentFrameIndex + i) % FRAMES_IN_FLIGHT]);
+        }
+    }
+}  // namespace lve
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// std
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace lve {
+    // Renders into images of its own instead of a swap chain, for a headless LveDevice.
+    //
+    // Every frame slot has a color and a depth image and a host visible readback buffer. endFrame()
+    // copies the color image into the buffer of its slot in the same submission, and the pixels go
+    // to the frame callback when beginFrame() comes back to that slot, FRAMES_IN_FLIGHT frames later,
+    // by which time the GPU has usually long finished. So the GPU never waits for the host, and the
+    // host only waits when it gets a whole ring ahead.
+    class LveOffscreenRenderer {
+    public:
+        static constexpr int FRAMES_IN_FLIGHT = LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+        // the swap chain's sRGB encoding, in the byte order of PPM and ffmpeg's rgba
+        static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+        // frameNumber counts the frames from 0 in submission order, which is also the order of the
+        // calls. rgba holds width * height tightly packed pixels, top row first, valid for the call.
+        using FrameCallback = std::function<void(uint64_t frameNumber, const uint8_t* rgba)>;
+
+        LveOffscreenRenderer(LveDevice& device, VkExtent2D extent, FrameCallback onFrame);
+        ~LveOffscreenRenderer();
+
+        LveOffscreenRenderer(const LveOffscreenRenderer&) = delete;
+        LveOffscreenRenderer& operator=(const LveOffscreenRenderer&) = delete;
+
+        // laid out like the swap chain's, so the render systems build their pipelines against it the same way
+        VkRenderPass getRenderPass() const { return renderPass; }
+        VkExtent2D getExtent() const { return extent; }
+        float getAspectRatio() const { return static_cast<float>(extent.width) / static_cast<float>(extent.height); }
+        VkFramebuffer getCurrentFramebuffer() const {
+            assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+            return slots[currentFrameIndex].framebuffer;
+        }
+        int getFrameIndex() const {
+            assert(isFrameStarted && "Cannot get frame index when frame not in progress");
+            return currentFrameIndex;
+        }
+
+        // hands the frame that last used the slot to the callback first, waiting for it if need be
+        VkCommandBuffer beginFrame();
+        // submits the frame with the copy of its color image into the readback buffer
+        void endFrame();
+        void beginRenderPass(VkCommandBuffer commandBuffer);
+        void endRenderPass(VkCommandBuffer commandBuffer);
+        // Waits for the frames still on the GPU and hands them to the callback. Frames not finished
+        // this way are dropped on destruction.
+        void finish();
+
+        uint64_t getFramesRead() const { return framesRead; }
+        double getReadbackWaitSeconds() const { return readbackWaitSeconds; }  // host blocked on a slot
+
+    private:
+        struct FrameSlot {
+            VkImage colorImage = VK_NULL_HANDLE;
+            LveAllocation colorMemory{};
+            VkImageView colorView = VK_NULL_HANDLE;
+            VkImage depthImage = VK_NULL_HANDLE;
+            LveAllocation depthMemory{};
+            VkImageView depthView = VK_NULL_HANDLE;
+            VkFramebuffer framebuffer = VK_NULL_HANDLE;
+            std::unique_ptr<LveBuffer> readbackBuffer;
+
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            bool pending = false;  // submitted and not handed to the callback yet
+            uint64_t frameNumber = 0;
+        };
+
+        void createRenderPass();
+        void createImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+            VkImage& image, LveAllocation& memory, VkImageView& view);
+        void createFrameSlot(FrameSlot& slot);
+        void retire(FrameSlot& slot);
+
+        LveDevice& lveDevice;
+        const VkExtent2D extent;
+        const FrameCallback onFrame;
+        VkFormat depthFormat;
+        VkRenderPass renderPass;
+        std::array<FrameSlot, FRAMES_IN_FLIGHT> slots;
+
+        int currentFrameIndex{ 0 };
+        bool isFrameStarted{ false };
+        uint64_t nextFrameNumber{ 0 };
+        uint64_t framesRead{ 0 };
+        double readbackWaitSeconds{ 0.0 };
+    };
+}  // namespace lve
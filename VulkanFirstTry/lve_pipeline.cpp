@@ -4,7 +4,9 @@
 
 // std
 #include <cassert>
+#include <exception>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <stdexcept>
 
@@ -19,10 +21,16 @@ namespace lve {
         createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
     }
 
+    LvePipeline::LvePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+        : lveDevice{ device }, bindPoint{ VK_PIPELINE_BIND_POINT_COMPUTE } {
+        createComputePipeline(compFilepath, pipelineLayout);
+    }
+
     LvePipeline::~LvePipeline() {
         vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
         vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+        vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+        vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
     }
 
     std::vector<char> LvePipeline::readFile(const std::string& filepath) {
@@ -75,8 +83,8 @@ namespace lve {
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+        auto& bindingDescriptions = configInfo.bindingDescriptions;
+        auto& attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputInfo.vertexAttributeDescriptionCount =
@@ -107,15 +115,65 @@ namespace lve {
 
         if (vkCreateGraphicsPipelines(
             lveDevice.device(),
-            VK_NULL_HANDLE,
+            lveDevice.pipelineCache(),
             1,
             &pipelineInfo,
             nullptr,
-            &graphicsPipeline) != VK_SUCCESS) {
+            &pipeline) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline");
         }
     }
 
+    void LvePipeline::createComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout) {
+        assert(
+            pipelineLayout != VK_NULL_HANDLE &&
+            "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto compCode = readFile(compFilepath);
+        createShaderModule(compCode, &compShaderModule);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = compShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (vkCreateComputePipelines(
+            lveDevice.device(),
+            lveDevice.pipelineCache(),
+            1,
+            &pipelineInfo,
+            nullptr,
+            &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+    }
+
+    void LvePipeline::createInParallel(const std::vector<std::function<void()>>& creators) {
+        std::vector<std::future<void>> pending;
+        pending.reserve(creators.size());
+        for (const auto& creator : creators) {
+            pending.push_back(std::async(std::launch::async, creator));
+        }
+
+        std::exception_ptr firstError;
+        for (auto& creation : pending) {
+            try {
+                creation.get();
+            }
+            catch (...) {
+                if (!firstError) firstError = std::current_exception();
+            }
+        }
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+    }
+
     void LvePipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule) {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -128,7 +186,7 @@ namespace lve {
     }
 
     void LvePipeline::bind(VkCommandBuffer commandBuffer) {
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
     }
 
     void LvePipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) {
@@ -200,6 +258,9 @@ namespace lve {
         configInfo.dynamicStateInfo.dynamicStateCount =
             static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
+
+        configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
     }
 
 }  // namespace lve
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "lve_device.hpp"
 
 // std
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,8 @@ namespace lve {
         PipelineConfigInfo(const PipelineConfigInfo&) = delete;
         PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -34,6 +37,8 @@ namespace lve {
             const std::string& vertFilepath,
             const std::string& fragFilepath,
             const PipelineConfigInfo& configInfo);
+        // a compute pipeline, bound to VK_PIPELINE_BIND_POINT_COMPUTE
+        LvePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
         ~LvePipeline();
 
         LvePipeline(const LvePipeline&) = delete;
@@ -43,6 +48,12 @@ namespace lve {
 
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
+        // Runs the given pipeline creations on a thread each and returns once all are done,
+        // rethrowing the first exception. Drivers compile the shaders inside vkCreate*Pipelines,
+        // and the device's pipeline cache is internally synchronized, so a system with several
+        // pipelines waits for the slowest one instead of the sum.
+        static void createInParallel(const std::vector<std::function<void()>>& creators);
+
     private:
         static std::vector<char> readFile(const std::string& filepath);
 
@@ -51,11 +62,15 @@ namespace lve {
             const std::string& fragFilepath,
             const PipelineConfigInfo& configInfo);
 
+        void createComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+
         void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
         LveDevice& lveDevice;
-        VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkPipeline pipeline;
+        VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        VkShaderModule compShaderModule = VK_NULL_HANDLE;
     };
 }  // namespace lve
\ No newline at end of file
@@ -1,14 +1,16 @@
 #include "lve_renderer.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <stdexcept>
 
 namespace lve {
 
-    LveRenderer::LveRenderer(LveWindow& window, LveDevice& device)
-        : lveWindow{ window }, lveDevice{ device } {
+    LveRenderer::LveRenderer(LveWindow& window, LveDevice& device, VkPresentModeKHR presentMode)
+        : lveWindow{ window }, lveDevice{ device }, preferredPresentMode{ presentMode } {
         recreateSwapChain();
         createCommandBuffers();
     }
@@ -24,11 +26,11 @@ namespace lve {
         vkDeviceWaitIdle(lveDevice.device());
 
         if (lveSwapChain == nullptr) {
-            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, preferredPresentMode);
         }
         else {
             std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain, preferredPresentMode);
 
             if (!oldSwapChain->compareSwapFormats(*lveSwapChain.get())) {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
@@ -60,11 +62,45 @@ namespace lve {
         commandBuffers.clear();
     }
 
+    void LveRenderer::setFramesInFlight(int count) {
+        assert(!isFrameStarted && "Can't change frames in flight while frame is in progress");
+        assert(
+            count >= 1 && count <= LveSwapChain::MAX_FRAMES_IN_FLIGHT &&
+            "Frames in flight must be between 1 and MAX_FRAMES_IN_FLIGHT");
+        // every slot is free once the device is idle, so numbering them anew is safe
+        vkDeviceWaitIdle(lveDevice.device());
+        framesInFlight = count;
+        currentFrameIndex = 0;
+        isFrameSlotReady = false;
+    }
+
+    void LveRenderer::setPresentMode(VkPresentModeKHR presentMode) {
+        assert(!isFrameStarted && "Can't change present mode while frame is in progress");
+        preferredPresentMode = presentMode;
+        recreateSwapChain();
+        isFrameSlotReady = false;
+    }
+
+    void LveRenderer::waitForFrameSlot() {
+        if (isFrameSlotReady) return;
+        auto start = std::chrono::high_resolution_clock::now();
+        lveSwapChain->waitForFrame(currentFrameIndex);
+        pendingFenceWait = std::chrono::duration<double, std::chrono::seconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        isFrameSlotReady = true;
+    }
+
     VkCommandBuffer LveRenderer::beginFrame() {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
-        auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+        waitForFrameSlot();
+        auto start = std::chrono::high_resolution_clock::now();
+        auto result = lveSwapChain->acquireNextImage(currentFrameIndex, &currentImageIndex);
+        const double acquireWait = std::chrono::duration<double, std::chrono::seconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            // the new swap chain comes with fresh fences
+            isFrameSlotReady = false;
             recreateSwapChain();
             return nullptr;
         }
@@ -74,6 +110,15 @@ namespace lve {
         }
 
         isFrameStarted = true;
+        if (fenceWaits.size() < STATS_WINDOW) {
+            fenceWaits.push_back(pendingFenceWait);
+            acquireWaits.push_back(acquireWait);
+        }
+        else {
+            fenceWaits[frameCount % STATS_WINDOW] = pendingFenceWait;
+            acquireWaits[frameCount % STATS_WINDOW] = acquireWait;
+        }
+        frameCount++;
 
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
@@ -92,7 +137,7 @@ namespace lve {
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        auto result = lveSwapChain->submitCommandBuffers(currentFrameIndex, &commandBuffer, &currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
             lveWindow.wasWindowResized()) {
             lveWindow.resetWindowResizedFlag();
@@ -103,10 +148,33 @@ namespace lve {
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+        isFrameSlotReady = false;
+        currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
+    }
+
+    FramePacingStats LveRenderer::getFramePacingStats() const {
+        FramePacingStats stats{};
+        stats.framesInFlight = framesInFlight;
+        stats.frameCount = frameCount;
+        for (size_t i = 0; i < fenceWaits.size(); i++) {
+            stats.averageFenceWait += fenceWaits[i];
+            stats.averageAcquireWait += acquireWaits[i];
+            stats.maxWait = std::max(stats.maxWait, fenceWaits[i] + acquireWaits[i]);
+        }
+        if (!fenceWaits.empty()) {
+            stats.averageFenceWait /= fenceWaits.size();
+            stats.averageAcquireWait /= acquireWaits.size();
+        }
+        return stats;
+    }
+
+    void printFramePacingStats(const FramePacingStats& stats, std::ostream& out) {
+        out << "frame pacing: " << stats.framesInFlight << " frames in flight, " << stats.frameCount << " frames\n"
+            << "  cpu wait per frame: " << stats.averageFenceWait * 1000.0 << " ms on the frame fence, "
+            << stats.averageAcquireWait * 1000.0 << " ms acquiring, " << stats.maxWait * 1000.0 << " ms worst\n";
     }
 
-    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
         assert(
             commandBuffer == getCurrentCommandBuffer() &&
@@ -126,7 +194,8 @@ namespace lve {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+        if (contents != VK_SUBPASS_CONTENTS_INLINE) return;
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -6,13 +6,32 @@
 
 // std
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <ostream>
 #include <vector>
 
 namespace lve {
+    // CPU time blocked on the GPU at the start of a frame, over the last STATS_WINDOW frames
+    struct FramePacingStats {
+        int framesInFlight = 0;
+        uint64_t frameCount = 0;         // since creation
+        double averageFenceWait = 0.0;   // seconds in waitForFrameSlot()
+        double averageAcquireWait = 0.0; // seconds in vkAcquireNextImageKHR
+        double maxWait = 0.0;            // worst of both together
+    };
+
+    void printFramePacingStats(const FramePacingStats& stats, std::ostream& out);
+
     class LveRenderer {
     public:
-        LveRenderer(LveWindow& window, LveDevice& device);
+        // Latency keeps one frame in flight, so input sampled after waitForFrameSlot() is on screen
+        // the soonest; Throughput keeps as many as there are slots, so the CPU and GPU overlap.
+        enum class FramePacing { Latency, Throughput };
+        static constexpr size_t STATS_WINDOW = 240;
+
+        LveRenderer(
+            LveWindow& window, LveDevice& device, VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
         ~LveRenderer();
 
         LveRenderer(const LveRenderer&) = delete;
@@ -20,6 +39,11 @@ namespace lve {
 
         VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
 		float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+		VkExtent2D getSwapChainExtent() const { return lveSwapChain->getSwapChainExtent(); }
+        VkFramebuffer getCurrentFramebuffer() const {
+            assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+            return lveSwapChain->getFrameBuffer(currentImageIndex);
+        }
         bool isFrameInProgress() const { return isFrameStarted; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
@@ -32,9 +56,28 @@ namespace lve {
             return currentFrameIndex;
         }
 
+        // between frames only, waits for the GPU to go idle first
+        void setFramesInFlight(int count);
+        void setFramePacing(FramePacing pacing) {
+            setFramesInFlight(pacing == FramePacing::Latency ? 1 : LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+        int getFramesInFlight() const { return framesInFlight; }
+
+        // rebuilds the swap chain, between frames only; getPresentMode() tells what the surface took
+        void setPresentMode(VkPresentModeKHR presentMode);
+        VkPresentModeKHR getPresentMode() const { return lveSwapChain->getPresentMode(); }
+        FramePacingStats getFramePacingStats() const;
+
+        // Blocks until the GPU is done with the frame that last used the next slot. beginFrame()
+        // does it when it has not been done yet; calling it before polling input makes the frame
+        // show the freshest input the pacing allows.
+        void waitForFrameSlot();
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS everything in the pass has to come from
+        // vkCmdExecuteCommands, and the secondary command buffers set their own viewport and scissor.
+        void beginSwapChainRenderPass(
+            VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
     private:
@@ -45,10 +88,19 @@ namespace lve {
         LveWindow& lveWindow;
         LveDevice& lveDevice;
         std::unique_ptr<LveSwapChain> lveSwapChain;
+        VkPresentModeKHR preferredPresentMode;
         std::vector<VkCommandBuffer> commandBuffers;
 
         uint32_t currentImageIndex;
         int currentFrameIndex{ 0 };
+        int framesInFlight{ 2 };
         bool isFrameStarted{ false };
+        bool isFrameSlotReady{ false };
+
+        // ring of the last STATS_WINDOW frames
+        std::vector<double> fenceWaits;
+        std::vector<double> acquireWaits;
+        double pendingFenceWait{ 0.0 };
+        uint64_t frameCount{ 0 };
     };
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "lve_secondary_recorder.hpp"
+
+#include "lve_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace lve {
+
+    LveSecondaryRecorder::LveSecondaryRecorder(LveDevice& device, unsigned int threadCount)
+        : lveDevice{ device }, pool{ threadCount } {
+        frameChunks.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& chunks : frameChunks) {
+            chunks.resize(pool.threadCount());
+            for (auto& chunk : chunks) {
+                VkCommandPoolCreateInfo poolInfo = {};
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &chunk.commandPool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create secondary command pool!");
+                }
+
+                VkCommandBufferAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                allocInfo.commandPool = chunk.commandPool;
+                allocInfo.commandBufferCount = 1;
+                if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &chunk.commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate secondary command buffer!");
+                }
+            }
+        }
+    }
+
+    LveSecondaryRecorder::~LveSecondaryRecorder() {
+        for (auto& chunks : frameChunks) {
+            for (auto& chunk : chunks) {
+                vkDestroyCommandPool(lveDevice.device(), chunk.commandPool, nullptr);
+            }
+        }
+    }
+
+    void LveSecondaryRecorder::record(
+        VkCommandBuffer primaryCommandBuffer,
+        int frameIndex,
+        VkRenderPass renderPass,
+        VkFramebuffer framebuffer,
+        VkExtent2D extent,
+        size_t count,
+        const RecordFunction& fn) {
+        chunkStats.clear();
+        recordSeconds = 0.0;
+        if (count == 0) return;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        auto& chunks = frameChunks[frameIndex];
+        // the fence of the frame has been waited on, none of its command buffers is pending anymore
+        for (auto& chunk : chunks) {
+            vkResetCommandPool(lveDevice.device(), chunk.commandPool, 0);
+        }
+
+        const size_t chunkSize = (count + chunks.size() - 1) / chunks.size();
+        const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+        chunkStats.resize(chunkCount);
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ {0, 0}, extent };
+
+        // the tiles of parallelFor are exactly the chunks, so tile i only ever touches chunk i; the pool
+        // does not handle exceptions, so the first failure is kept and rethrown once every tile is done
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        pool.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+            try {
+                auto chunkStart = std::chrono::high_resolution_clock::now();
+                const size_t index = begin / chunkSize;
+                VkCommandBuffer commandBuffer = chunks[index].commandBuffer;
+
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags =
+                    VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                beginInfo.pInheritanceInfo = &inheritanceInfo;
+                if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to begin recording secondary command buffer!");
+                }
+                vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+                vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+                fn(commandBuffer, begin, end);
+
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to record secondary command buffer!");
+                }
+                chunkStats[index].itemCount = end - begin;
+                chunkStats[index].recordSeconds = std::chrono::duration<double, std::chrono::seconds::period>(
+                    std::chrono::high_resolution_clock::now() - chunkStart).count();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock{ failureMutex };
+                if (!failure) failure = std::current_exception();
+            }
+        });
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+
+        std::vector<VkCommandBuffer> commandBuffers(chunkCount);
+        for (size_t i = 0; i < chunkCount; i++) {
+            commandBuffers[i] = chunks[i].commandBuffer;
+        }
+        vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(chunkCount), commandBuffers.data());
+        recordSeconds = std::chrono::duration<double, std::chrono::seconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void printRecordingStats(const LveSecondaryRecorder& recorder, std::ostream& out) {
+        const auto& chunks = recorder.getChunkStats();
+        out << "secondary recording: " << chunks.size() << " chunks on " << recorder.threadCount() << " threads in "
+            << recorder.getRecordSeconds() * 1000.0 << " ms\n";
+        for (size_t i = 0; i < chunks.size(); i++) {
+            out << "  chunk " << i << ": " << chunks[i].itemCount << " items in " << chunks[i].recordSeconds * 1000.0
+                << " ms\n";
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "thread_pool.hpp"
+
+// std
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace lve {
+
+    // Records a range of work into secondary command buffers on several threads and executes them
+    // from a primary one.
+    //
+    // The range is split into one chunk per pool thread. Every chunk records into its own command
+    // buffer from its own command pool, so no pool is ever touched by two threads. There is a set of
+    // pools per frame in flight, reset as a whole when its frame records again.
+    class LveSecondaryRecorder {
+    public:
+        // records the items [begin, end) into commandBuffer, called from the pool threads
+        using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+        struct ChunkStats {
+            size_t itemCount = 0;
+            double recordSeconds = 0.0;  // begin to end of its command buffer
+        };
+
+        // 0 picks std::thread::hardware_concurrency()
+        LveSecondaryRecorder(LveDevice& device, unsigned int threadCount = 0);
+        ~LveSecondaryRecorder();
+
+        LveSecondaryRecorder(const LveSecondaryRecorder&) = delete;
+        LveSecondaryRecorder& operator=(const LveSecondaryRecorder&) = delete;
+
+        unsigned int threadCount() const { return pool.threadCount(); }
+
+        // Records [0, count) with fn and executes the chunks in order into primaryCommandBuffer. It
+        // has to be inside subpass 0 of renderPass on framebuffer, begun with
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. Secondary command buffers do not inherit
+        // dynamic state, so each chunk starts with the viewport and scissor of extent set.
+        void record(
+            VkCommandBuffer primaryCommandBuffer,
+            int frameIndex,
+            VkRenderPass renderPass,
+            VkFramebuffer framebuffer,
+            VkExtent2D extent,
+            size_t count,
+            const RecordFunction& fn);
+
+        // of the last record(), one per chunk
+        const std::vector<ChunkStats>& getChunkStats() const { return chunkStats; }
+        double getRecordSeconds() const { return recordSeconds; }  // wall time of the last record()
+
+    private:
+        struct Chunk {
+            VkCommandPool commandPool;
+            VkCommandBuffer commandBuffer;
+        };
+
+        LveDevice& lveDevice;
+        ThreadPool pool;
+        std::vector<std::vector<Chunk>> frameChunks;  // per frame in flight, one per thread
+
+        std::vector<ChunkStats> chunkStats;
+        double recordSeconds = 0.0;
+    };
+
+    void printRecordingStats(const LveSecondaryRecorder& recorder, std::ostream& out);
+
+}  // namespace lve
@@ -1,24 +1,40 @@
 #include "lve_swap_chain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
-#include <iostream>
 #include <limits>
 #include <set>
 #include <stdexcept>
 
 namespace lve {
 
-    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent)
-        : device{ deviceRef }, windowExtent{ extent } {
+    const char* presentModeName(VkPresentModeKHR presentMode) {
+        switch (presentMode) {
+        case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO relaxed";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        default: return "unknown";
+        }
+    }
+
+    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent, VkPresentModeKHR preferredPresentMode)
+        : preferredPresentMode{ preferredPresentMode }, device{ deviceRef }, windowExtent{ extent } {
         init();
     }
 
     LveSwapChain::LveSwapChain(
-        LveDevice& deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+        LveDevice& deviceRef,
+        VkExtent2D extent,
+        std::shared_ptr<LveSwapChain> previous,
+        VkPresentModeKHR preferredPresentMode)
+        : preferredPresentMode{ preferredPresentMode },
+        device{ deviceRef },
+        windowExtent{ extent },
+        oldSwapChain{ previous } {
         init();
         oldSwapChain = nullptr;
     }
@@ -46,7 +62,7 @@ namespace lve {
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
             vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.freeMemory(depthImageMemorys[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) {
@@ -56,42 +72,44 @@ namespace lve {
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
+        for (auto semaphore : renderFinishedSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
             vkDestroyFence(device.device(), inFlightFences[i], nullptr);
         }
     }
 
-    VkResult LveSwapChain::acquireNextImage(uint32_t* imageIndex) {
+    void LveSwapChain::waitForFrame(int frameIndex) {
         vkWaitForFences(
             device.device(),
             1,
-            &inFlightFences[currentFrame],
+            &inFlightFences[frameIndex],
             VK_TRUE,
             std::numeric_limits<uint64_t>::max());
+    }
 
+    VkResult LveSwapChain::acquireNextImage(int frameIndex, uint32_t* imageIndex) {
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
             swapChain,
             std::numeric_limits<uint64_t>::max(),
-            imageAvailableSemaphores[currentFrame],  // must be a not signaled semaphore
+            imageAvailableSemaphores[frameIndex],  // must be a not signaled semaphore
             VK_NULL_HANDLE,
             imageIndex);
 
         return result;
     }
 
-    VkResult LveSwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-        }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
+    // No wait for the frame that last rendered to the image: the image only becomes available, and
+    // this submission only starts, after its previous present, which waited for that frame.
+    VkResult LveSwapChain::submitCommandBuffers(
+        int frameIndex, const VkCommandBuffer* buffers, uint32_t* imageIndex) {
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[frameIndex] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
@@ -100,12 +118,12 @@ namespace lve {
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
-        VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
+        VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[*imageIndex] };
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+        vkResetFences(device.device(), 1, &inFlightFences[frameIndex]);
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[frameIndex]) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
@@ -122,18 +140,14 @@ namespace lve {
 
         presentInfo.pImageIndices = imageIndex;
 
-        auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
-
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-
-        return result;
+        return vkQueuePresentKHR(device.presentQueue(), &presentInfo);
     }
 
     void LveSwapChain::createSwapChain() {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -349,9 +363,8 @@ namespace lve {
 
     void LveSwapChain::createSyncObjects() {
         imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+        renderFinishedSemaphores.resize(imageCount());
         inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -362,13 +375,16 @@ namespace lve {
 
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
                 VK_SUCCESS ||
                 vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
+        for (auto& semaphore : renderFinishedSemaphores) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create synchronization objects for an image!");
+            }
+        }
     }
 
     VkSurfaceFormatKHR LveSwapChain::chooseSwapSurfaceFormat(
@@ -385,21 +401,10 @@ namespace lve {
 
     VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR>& availablePresentModes) {
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
-            }
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode) !=
+            availablePresentModes.end()) {
+            return preferredPresentMode;
         }
-
-        for (const auto &availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-                std::cout << "Present mode: Immediate" << std::endl;
-                return availablePresentMode;
-            }
-        }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
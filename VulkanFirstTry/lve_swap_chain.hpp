@@ -12,13 +12,25 @@
 
 namespace lve {
 
+    // "FIFO", "FIFO relaxed", "mailbox", "immediate" or "unknown"
+    const char* presentModeName(VkPresentModeKHR presentMode);
+
     class LveSwapChain {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+        // upper bound of LveRenderer::setFramesInFlight(), per-frame resources come in this many
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 
-        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent);
+        // preferredPresentMode is used when the surface supports it, FIFO otherwise, which every
+        // surface does
+        LveSwapChain(
+            LveDevice& deviceRef,
+            VkExtent2D windowExtent,
+            VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
         LveSwapChain(
-            LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
+            LveDevice& deviceRef,
+            VkExtent2D windowExtent,
+            std::shared_ptr<LveSwapChain> previous,
+            VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 
         ~LveSwapChain();
 
@@ -31,6 +43,7 @@ namespace lve {
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
 
@@ -39,8 +52,11 @@ namespace lve {
         }
         VkFormat findDepthFormat();
 
-        VkResult acquireNextImage(uint32_t* imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        // Frame slots are picked by the renderer. Waiting on a slot waits for the frame submitted from
+        // it last, so with n slots in use the CPU stays at most n frames ahead of the GPU.
+        void waitForFrame(int frameIndex);
+        VkResult acquireNextImage(int frameIndex, uint32_t* imageIndex);
+        VkResult submitCommandBuffers(int frameIndex, const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
         bool compareSwapFormats(const LveSwapChain& swapChain) const {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -63,6 +79,8 @@ namespace lve {
             const std::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+        VkPresentModeKHR preferredPresentMode;
+        VkPresentModeKHR presentMode;
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
@@ -71,7 +89,7 @@ namespace lve {
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<LveAllocation> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
@@ -82,11 +100,9 @@ namespace lve {
         VkSwapchainKHR swapChain;
         std::shared_ptr<LveSwapChain> oldSwapChain;
 
-        std::vector<VkSemaphore> imageAvailableSemaphores;
-        std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
-        size_t currentFrame = 0;
+        std::vector<VkSemaphore> imageAvailableSemaphores;  // per frame slot
+        std::vector<VkSemaphore> renderFinishedSemaphores;  // per image, free again once it is acquired
+        std::vector<VkFence> inFlightFences;                // per frame slot
     };
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "lve_upload_manager.hpp"
+
+#include "lve_device.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+    LveUploadManager::LveUploadManager(LveDevice& device) : lveDevice{ device } {
+        createCommandPool();
+        lveDevice.createBuffer(
+            STAGING_BUFFER_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingMemory);
+    }
+
+    LveUploadManager::~LveUploadManager() {
+        waitIdle();
+        for (auto& batch : freeBatches) {
+            vkDestroyFence(lveDevice.device(), batch.fence, nullptr);
+        }
+        vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+        vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
+        lveDevice.freeMemory(stagingMemory);
+    }
+
+    void LveUploadManager::createCommandPool() {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().transferFamily;
+        poolInfo.flags =
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+    }
+
+    LveUploadManager::Ticket LveUploadManager::upload(
+        VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        const char* source = static_cast<const char*>(data);
+        while (size > 0) {
+            VkDeviceSize granted;
+            const VkDeviceSize offset = reserve(size, granted);
+            if (open.commandBuffer == VK_NULL_HANDLE) {
+                beginBatch();
+            }
+
+            memcpy(static_cast<char*>(stagingMemory.mapped) + offset, source, static_cast<size_t>(granted));
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = offset;
+            copyRegion.dstOffset = dstOffset;
+            copyRegion.size = granted;
+            vkCmdCopyBuffer(open.commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+
+            source += granted;
+            dstOffset += granted;
+            size -= granted;
+            uploadedBytes += granted;
+        }
+        return open.commandBuffer != VK_NULL_HANDLE ? open.ticket : nextTicket - 1;
+    }
+
+    LveUploadManager::Ticket LveUploadManager::flush() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return submitBatch();
+    }
+
+    bool LveUploadManager::isComplete(Ticket ticket) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        retireCompleted();
+        return ticket <= completedTicket;
+    }
+
+    void LveUploadManager::wait(Ticket ticket) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (open.commandBuffer != VK_NULL_HANDLE && ticket >= open.ticket) {
+            submitBatch();
+        }
+        while (ticket > completedTicket && !inFlight.empty()) {
+            retireOldest();
+        }
+    }
+
+    void LveUploadManager::beginBatch() {
+        Batch batch{};
+        if (!freeBatches.empty()) {
+            batch = freeBatches.back();
+            freeBatches.pop_back();
+        }
+        else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &batch.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload fence!");
+            }
+        }
+        // the ring bytes reserved for the first upload are already counted on the open batch
+        batch.ringBytes = open.ringBytes;
+        batch.ticket = nextTicket++;
+        open = batch;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(open.commandBuffer, &beginInfo);
+    }
+
+    // The fence orders the copies before whatever the host submits after waiting for it, on any
+    // queue. The barrier covers the graphics queue doubling as the transfer queue.
+    LveUploadManager::Ticket LveUploadManager::submitBatch() {
+        if (open.commandBuffer == VK_NULL_HANDLE) {
+            return nextTicket - 1;
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(
+            open.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+        vkEndCommandBuffer(open.commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &open.commandBuffer;
+        if (vkQueueSubmit(lveDevice.transferQueue(), 1, &submitInfo, open.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+        submitCount++;
+
+        const Ticket ticket = open.ticket;
+        inFlight.push_back(open);
+        open = {};
+        return ticket;
+    }
+
+    VkDeviceSize LveUploadManager::reserve(VkDeviceSize size, VkDeviceSize& granted) {
+        while (true) {
+            retireCompleted();
+            if (usedBytes == 0) {
+                head = 0;
+            }
+
+            if (usedBytes < STAGING_BUFFER_SIZE) {
+                const VkDeviceSize tail = (head + STAGING_BUFFER_SIZE - usedBytes) % STAGING_BUFFER_SIZE;
+                VkDeviceSize contiguous = head < tail ? tail - head : STAGING_BUFFER_SIZE - head;
+                // skip the end of the ring when the start has more room for this upload
+                if (head >= tail && contiguous < size && tail > contiguous) {
+                    usedBytes += contiguous;
+                    open.ringBytes += contiguous;
+                    head = 0;
+                    contiguous = tail;
+                }
+
+                granted = std::min(size, contiguous);
+                const VkDeviceSize consumed =
+                    std::min(contiguous, (granted + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT);
+                const VkDeviceSize offset = head;
+                head = (head + consumed) % STAGING_BUFFER_SIZE;
+                usedBytes += consumed;
+                open.ringBytes += consumed;
+                return offset;
+            }
+
+            // the ring is full: make room by waiting for the oldest batch, which may be the open one
+            if (inFlight.empty()) {
+                submitBatch();
+            }
+            retireOldest();
+        }
+    }
+
+    void LveUploadManager::retireCompleted() {
+        while (!inFlight.empty() && vkGetFenceStatus(lveDevice.device(), inFlight.front().fence) == VK_SUCCESS) {
+            retireOldest();
+        }
+    }
+
+    void LveUploadManager::retireOldest() {
+        Batch batch = inFlight.front();
+        inFlight.pop_front();
+        vkWaitForFences(lveDevice.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(lveDevice.device(), 1, &batch.fence);
+
+        assert(usedBytes >= batch.ringBytes && "Ring accounting out of sync");
+        usedBytes -= batch.ringBytes;
+        completedTicket = batch.ticket;
+        batch.ringBytes = 0;
+        freeBatches.push_back(batch);
+    }
+
+}  // namespace lve
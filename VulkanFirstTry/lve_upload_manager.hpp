@@ -0,0 +1,83 @@
+#pragma once
+
+#include "lve_allocator.hpp"
+
+// std
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+    class LveDevice;
+
+    // Streams data into device local buffers through a ring of host visible staging memory.
+    //
+    // Uploads are copied into the ring and recorded into one command buffer, which goes to the
+    // transfer queue as a single submission on flush(), or when the ring runs out of room. Each
+    // submission signals a fence; its ticket tells when the copies are done, so callers wait for
+    // exactly their batch instead of the whole queue. Ring space comes back once a batch's fence has
+    // signaled.
+    class LveUploadManager {
+    public:
+        using Ticket = uint64_t;
+
+        static constexpr VkDeviceSize STAGING_BUFFER_SIZE = 16 * 1024 * 1024;
+        static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;  // optimalBufferCopyOffsetAlignment at most
+
+        LveUploadManager(LveDevice& device);
+        ~LveUploadManager();
+
+        LveUploadManager(const LveUploadManager&) = delete;
+        LveUploadManager& operator=(const LveUploadManager&) = delete;
+
+        // Copies size bytes of data to dstOffset in dstBuffer, which needs TRANSFER_DST usage. data
+        // may be freed on return. Uploads larger than the ring are split. Thread safe.
+        Ticket upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+        // submits the pending uploads, returns the ticket of the last batch
+        Ticket flush();
+        bool isComplete(Ticket ticket);
+        // flushes if ticket is still pending, then waits for its fence
+        void wait(Ticket ticket);
+        void waitIdle() { wait(flush()); }
+
+        uint64_t getSubmitCount() const { return submitCount; }
+        uint64_t getUploadedBytes() const { return uploadedBytes; }
+
+    private:
+        struct Batch {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            VkDeviceSize ringBytes = 0;  // staging bytes held until the fence signals
+            Ticket ticket = 0;
+        };
+
+        void createCommandPool();
+        void beginBatch();
+        Ticket submitBatch();
+        // offset of up to size contiguous ring bytes, at least one; waits for batches when full
+        VkDeviceSize reserve(VkDeviceSize size, VkDeviceSize& granted);
+        void retireCompleted();
+        void retireOldest();
+
+        LveDevice& lveDevice;
+        VkCommandPool commandPool;
+
+        std::mutex mutex;
+        VkBuffer stagingBuffer;
+        LveAllocation stagingMemory;
+        VkDeviceSize head = 0;      // next free byte of the ring
+        VkDeviceSize usedBytes = 0;  // held by the open and the in flight batches
+
+        Batch open{};                 // recording, commandBuffer is null when nothing is pending
+        std::deque<Batch> inFlight;   // oldest first
+        std::vector<Batch> freeBatches;
+        Ticket nextTicket = 1;
+        Ticket completedTicket = 0;  // every batch up to this one has finished
+
+        uint64_t submitCount = 0;
+        uint64_t uploadedBytes = 0;
+    };
+
+}  // namespace lve
@@ -1,15 +1,266 @@
-
 #include "first_app.hpp"
+#include "gpu_cull_system.hpp"
+#include "gpu_nbody_system.hpp"
+#include "lve_offscreen_renderer.hpp"
+#include "offscreen_app.hpp"
+#include "physics_benchmark.hpp"
+#include "model.hpp"
+#include "physics_system.hpp"
+
+//libs
+#include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <random>
 #include <stdexcept>
+#include <string>
+
+// VulkanFirstTry --check-culling [instances]
+// culls random circles and rectangles with the compute pass and compares the visible counts with
+// the same test on the CPU; runs on any Vulkan driver, lavapipe included, without a display
+static int runCullingCheck(int argc, char** argv) {
+    const size_t instanceCount = argc > 2 ? std::stoul(argv[2]) : 100000;
+
+    lve::LveDevice device{};  // headless, the cull pass needs no surface
+    std::shared_ptr<lve::LveModel> circleModel = lve::Model::createCircleModel(device, 16);
+    std::shared_ptr<lve::LveModel> rectangleModel = lve::Model::createRectangleModel(device, glm::vec3{ 1.f });
+
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> position{ -20.f, 20.f };
+    std::uniform_real_distribution<float> size{ 0.01f, 0.5f };
+    std::uniform_real_distribution<float> angle{ 0.f, glm::two_pi<float>() };
+    std::vector<lve::LveGameObject> objects;
+    objects.reserve(instanceCount);
+    for (size_t i = 0; i < instanceCount; i++) {
+        auto obj = lve::LveGameObject::createGameObject();
+        obj.model = i % 3 == 0 ? rectangleModel : circleModel;
+        obj.transform.translation = { position(rng), position(rng), position(rng) };
+        obj.transform.scale = { size(rng), size(rng), 1.f };
+        obj.transform.rotation = { angle(rng), angle(rng), angle(rng) };
+        objects.push_back(std::move(obj));
+    }
+
+    lve::LveCamera camera{};
+    camera.setViewYXZ({ 0.f, 0.f, -3.f }, { 0.3f, 0.5f, 0.f });
+    camera.setPerspectiveProjection(glm::radians(45.f), 1.f, 0.1f, 30.f);
+
+    lve::GpuCullSystem cullSystem{ device };
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    cullSystem.cull(commandBuffer, 0, { &objects }, camera);
+    device.endSingleTimeCommands(commandBuffer);  // waits for the queue to go idle
+
+    const auto gpuCounts = cullSystem.readVisibleCounts(0);
+    const auto hostCounts = lve::GpuCullSystem::cullOnHost({ &objects }, camera);
+
+    // a sphere that touches a plane within rounding may land on either side, allow one in 10^4
+    size_t mismatches = 0;
+    for (size_t i = 0; i < hostCounts.size(); i++) {
+        std::cout << "draw " << i << ": " << gpuCounts[i] << " visible on the GPU, " << hostCounts[i]
+                  << " on the CPU, of " << cullSystem.getDraws(0)[i].instanceCount << "\n";
+        mismatches += gpuCounts[i] > hostCounts[i] ? gpuCounts[i] - hostCounts[i] : hostCounts[i] - gpuCounts[i];
+    }
+    const bool passed = gpuCounts.size() == hostCounts.size() && mismatches * 10000 <= instanceCount;
+    lve::printAllocatorStats(device.getAllocator().getStats(), std::cout);
+    std::cout << (passed ? "culling check passed" : "culling check FAILED") << "\n";
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// VulkanFirstTry --check-gpu-nbody [bodies] [steps]
+// steps a random scene with the compute integrator and with PhysicsSystem's direct sum and
+// compares the final state; runs on any Vulkan driver, lavapipe included, without a display
+static int runGpuNbodyCheck(int argc, char** argv) {
+    const size_t bodyCount = argc > 2 ? std::stoul(argv[2]) : 2000;
+    const unsigned int steps = argc > 3 ? static_cast<unsigned int>(std::stoul(argv[3])) : 20;
+    const float dt = 0.001f;
+
+    lve::LveDevice device{};  // headless
+    lve::LveOffscreenRenderer renderer{ device, { 1, 1 }, nullptr };  // only for the render pass
+
+    lve::BodyStore hostBodies = lve::makeRandomScene(bodyCount, 1);
+    lve::BodyStore gpuBodies = hostBodies;
+
+    lve::PhysicsSystem physicsSystem{ 1.0f, 1.0f };
+    for (unsigned int step = 0; step < steps; step++) {
+        physicsSystem.update(hostBodies, dt);
+    }
+    if (hostBodies.size() != gpuBodies.size()) {
+        std::cout << "bodies merged on the CPU, which the GPU does not do; pick fewer steps\n";
+        std::cout << "gpu n-body check FAILED\n";
+        return EXIT_FAILURE;
+    }
+
+    lve::GpuNbodySystem nbodySystem{ device, renderer.getRenderPass(), 1.0f, 1.0f };
+    nbodySystem.upload(gpuBodies);
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    for (unsigned int step = 0; step < steps; step++) {
+        nbodySystem.update(commandBuffer, dt);
+    }
+    device.endSingleTimeCommands(commandBuffer);
+    nbodySystem.download(gpuBodies);
+
+    // relative to the magnitude, or absolute below one
+    auto relativeError = [](const std::vector<float>& expected, const std::vector<float>& actual) {
+        float error = 0.0f;
+        for (size_t i = 0; i < expected.size(); i++) {
+            error = std::max(error, std::abs(actual[i] - expected[i]) / std::max(1.0f, std::abs(expected[i])));
+        }
+        return error;
+    };
+    const float positionError = std::max({
+        relativeError(hostBodies.x, gpuBodies.x),
+        relativeError(hostBodies.y, gpuBodies.y),
+        relativeError(hostBodies.z, gpuBodies.z) });
+    const float velocityError = std::max({
+        relativeError(hostBodies.vx, gpuBodies.vx),
+        relativeError(hostBodies.vy, gpuBodies.vy),
+        relativeError(hostBodies.vz, gpuBodies.vz) });
+    std::cout << bodyCount << " bodies, " << steps << " steps: max position error " << positionError
+              << ", max velocity error " << velocityError << "\n";
+
+    // the GPU sums in another order and with its own inversesqrt
+    const bool passed = positionError < 1e-3f && velocityError < 1e-3f;
+    lve::printAllocatorStats(device.getAllocator().getStats(), std::cout);
+    std::cout << (passed ? "gpu n-body check passed" : "gpu n-body check FAILED") << "\n";
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// VulkanFirstTry --render [scene] [--frames N] [--size WxH] [--steps-per-frame N] [--impostors]
+//                         [--ppm prefix | --raw file | --pipe command]
+// renders a scene file without a window, on any Vulkan driver, lavapipe included; a video straight
+// from ffmpeg with for instance
+//   --pipe "ffmpeg -y -f rawvideo -pixel_format rgba -video_size 1280x720 -framerate 60 -i - run.mp4"
+static int runOffscreenRender(int argc, char** argv) {
+    lve::OffscreenAppConfig config{};
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) config.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--steps-per-frame" && hasValue) config.stepsPerFrame = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--size" && hasValue) {
+            const std::string size = argv[++i];
+            const size_t x = size.find('x');
+            if (x == std::string::npos) throw std::runtime_error("--size takes WIDTHxHEIGHT, not " + size);
+            config.extent.width = static_cast<uint32_t>(std::stoul(size.substr(0, x)));
+            config.extent.height = static_cast<uint32_t>(std::stoul(size.substr(x + 1)));
+        }
+        else if (arg == "--impostors") config.impostorBodies = true;
+        else if (arg == "--ppm" && hasValue) {
+            config.output = lve::FrameOutput::Ppm;
+            config.target = argv[++i];
+        }
+        else if (arg == "--raw" && hasValue) {
+            config.output = lve::FrameOutput::Raw;
+            config.target = argv[++i];
+        }
+        else if (arg == "--pipe" && hasValue) {
+            config.output = lve::FrameOutput::Pipe;
+            config.target = argv[++i];
+        }
+        else if (arg.rfind("--", 0) != 0) config.scenePath = arg;
+        else throw std::runtime_error("unknown argument " + arg);
+    }
+
+    lve::OffscreenApp app{ config };
+    app.run();
+    return EXIT_SUCCESS;
+}
 
-int main() {
-    lve::FirstApp app{};
+static bool parsePresentMode(const std::string& name, VkPresentModeKHR& presentMode) {
+    if (name == "fifo") presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    else if (name == "fifo-relaxed") presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    else if (name == "mailbox") presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    else if (name == "immediate") presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    else return false;
+    return true;
+}
+
+// VulkanFirstTry [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--benchmark [frames]] [--gpu-physics]
+//                [--parallel-recording] [--impostors] [--frames-in-flight N | --pacing latency|throughput]
+// --benchmark closes after timing frames frames, uncapped with immediate present unless a mode is given;
+// --gpu-physics steps the bodies with the compute pass instead of the physics thread;
+// --parallel-recording records one draw per object on all cores and reports the time per thread;
+// --impostors draws the bodies as shaded sphere quads instead of circle meshes;
+// --pacing latency keeps one frame in flight, throughput as many as the swap chain has slots
+static bool parseAppConfig(int argc, char** argv, lve::FirstAppConfig& config) {
+    bool presentModeGiven = false;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--present-mode" && i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], config.presentMode)) {
+                std::cerr << "unknown present mode " << argv[i] << '\n';
+                return false;
+            }
+            presentModeGiven = true;
+        }
+        else if (arg == "--benchmark") {
+            config.benchmarkFrames = 2000;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                config.benchmarkFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+        }
+        else if (arg == "--gpu-physics") {
+            config.gpuPhysics = true;
+        }
+        else if (arg == "--parallel-recording") {
+            config.parallelRecording = true;
+        }
+        else if (arg == "--impostors") {
+            config.impostorBodies = true;
+        }
+        else if (arg == "--frames-in-flight" && i + 1 < argc) {
+            const std::string count = argv[++i];
+            config.framesInFlight = std::isdigit(static_cast<unsigned char>(count[0])) ? std::stoi(count) : 0;
+            if (config.framesInFlight < 1 || config.framesInFlight > lve::LveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+                std::cerr << "frames in flight must be between 1 and " << lve::LveSwapChain::MAX_FRAMES_IN_FLIGHT << '\n';
+                return false;
+            }
+        }
+        else if (arg == "--pacing" && i + 1 < argc) {
+            const std::string pacing = argv[++i];
+            if (pacing == "latency") config.framesInFlight = 1;
+            else if (pacing == "throughput") config.framesInFlight = lve::LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+            else {
+                std::cerr << "unknown pacing " << pacing << '\n';
+                return false;
+            }
+        }
+        else {
+            std::cerr << "unknown argument " << arg << '\n';
+            return false;
+        }
+    }
+    if (config.benchmarkFrames > 0 && !presentModeGiven) {
+        config.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--check-culling" || mode == "--check-gpu-nbody" || mode == "--render") {
+        try {
+            if (mode == "--check-culling") return runCullingCheck(argc, argv);
+            if (mode == "--check-gpu-nbody") return runGpuNbodyCheck(argc, argv);
+            return runOffscreenRender(argc, argv);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    lve::FirstAppConfig config{};
+    if (!parseAppConfig(argc, argv, config)) {
+        return EXIT_FAILURE;
+    }
 
     try {
+        lve::FirstApp app{ config };
         app.run();
     }
     catch (const std::exception& e) {
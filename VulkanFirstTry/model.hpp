@@ -28,13 +28,14 @@ namespace lve {
             }
             uniqueVertices.push_back({});  // adds center vertex at 0, 0
 
-            std::vector<LveModel::Vertex> vertices{};
+            LveModel::Builder builder{};
+            builder.vertices = uniqueVertices;
             for (int i = 0; i < numSides; i++) {
-                vertices.push_back(uniqueVertices[i]);
-                vertices.push_back(uniqueVertices[(i + 1) % numSides]);
-                vertices.push_back(uniqueVertices[numSides]);
+                builder.indices.push_back(i);
+                builder.indices.push_back((i + 1) % numSides);
+                builder.indices.push_back(numSides);
             }
-            return std::make_unique<LveModel>(device, vertices);
+            return std::make_unique<LveModel>(device, builder);
         }
 		static void sierpinski(std::vector<LveModel::Vertex>& vertices, int depth, glm::vec3 left, glm::vec3 right, glm::vec3 top) {
             if (depth <= 0) {
@@ -62,7 +63,7 @@ namespace lve {
             vertices.push_back({ glm::vec3{ 1.0f, 1.0f, 0.0f }, color });
             vertices.push_back({ glm::vec3{ -1.0f, 1.0f, 0.0f }, color });
 
-            return std::make_unique<LveModel>(device, vertices);
+            return std::make_unique<LveModel>(device, LveModel::Builder::weld(vertices));
         }
 		static std::unique_ptr<LveModel> createCrossModel(LveDevice& device, glm::vec3 color) {
             std::vector<LveModel::Vertex> vertices{};
@@ -92,7 +93,7 @@ namespace lve {
             vertices.push_back({ glm::vec3{ 1.0f, 0.5f, 0.0f }, color });
 
 
-            return std::make_unique<LveModel>(device, vertices);
+            return std::make_unique<LveModel>(device, LveModel::Builder::weld(vertices));
         }
         static std::unique_ptr<LveModel> createCubeModel(LveDevice& device, glm::vec3 offset) {
             std::vector<LveModel::Vertex> vertices{
@@ -149,7 +150,7 @@ namespace lve {
             for (auto& v : vertices) {
                 v.position += offset;
             }
-            return std::make_unique<LveModel>(device, vertices);
+            return std::make_unique<LveModel>(device, LveModel::Builder::weld(vertices));
         }
 	};
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "offscreen_app.hpp"
+#include "lve_buffer.hpp"
+#include "lve_camera.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_offscreen_renderer.hpp"
+#include "model.hpp"
+#include "physics_system.hpp"
+#include "simple_render_system.hpp"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace lve {
+    OffscreenApp::OffscreenApp(const OffscreenAppConfig& config)
+        : config{ config }, scene{ loadScene(config.scenePath) } {
+        globalPool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(LveOffscreenRenderer::FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveOffscreenRenderer::FRAMES_IN_FLIGHT)
+            .build();
+        loadGameObjects();
+    }
+
+    OffscreenApp::~OffscreenApp() {}
+
+    void OffscreenApp::loadGameObjects() {
+        circleModel = Model::createCircleModel(lveDevice, 64);
+        bodyObjects.clear();
+        bodyObjects.reserve(scene.bodies.size());
+        for (size_t i = 0; i < scene.bodies.size(); i++) {
+            auto obj = LveGameObject::createGameObject();
+            obj.model = circleModel;
+            // the sync walk matches bodies and objects by id
+            scene.bodies.ids[i] = obj.getId();
+            bodyObjects.push_back(std::move(obj));
+        }
+        syncGameObjects();
+    }
+
+    void OffscreenApp::syncGameObjects() {
+        // the store keeps the load order, like in FirstApp::syncPhysicsObjects
+        const BodyStore& bodies = scene.bodies;
+        size_t body = 0;
+        auto merged = std::remove_if(bodyObjects.begin(), bodyObjects.end(), [&](LveGameObject& obj) {
+            if (body >= bodies.size() || bodies.ids[body] != obj.getId()) {
+                return true;
+            }
+            obj.transform.translation = { bodies.x[body], bodies.y[body], bodies.z[body] };
+            obj.transform.scale = glm::vec3{ bodies.radius[body] };
+            obj.color = { bodies.colorR[body], bodies.colorG[body], bodies.colorB[body] };
+            body++;
+            return false;
+        });
+        bodyObjects.erase(merged, bodyObjects.end());
+    }
+
+    void OffscreenApp::run() {
+        PhysicsSystem physicsSystem{ scene.gravity, scene.unitScale };
+        scene.configure(physicsSystem);
+
+        FrameWriter frameWriter{ config.output, config.target, config.extent.width, config.extent.height };
+        LveOffscreenRenderer renderer{ lveDevice, config.extent, [&](uint64_t frameNumber, const uint8_t* rgba) {
+            frameWriter.write(frameNumber, rgba);
+        } };
+
+        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveOffscreenRenderer::FRAMES_IN_FLIGHT);
+        for (auto& uboBuffer : uboBuffers) {
+            uboBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(GlobalUbo),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            uboBuffer->map();
+        }
+
+        auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .build();
+
+        std::vector<VkDescriptorSet> globalDescriptorSets(LveOffscreenRenderer::FRAMES_IN_FLIGHT);
+        for (size_t i = 0; i < globalDescriptorSets.size(); i++) {
+            auto bufferInfo = uboBuffers[i]->descriptorInfo();
+            LveDescriptorWriter(*globalSetLayout, *globalPool)
+                .writeBuffer(0, &bufferInfo)
+                .build(globalDescriptorSets[i]);
+        }
+
+        SimpleRenderSystem simpleRenderSystem{
+            lveDevice, renderer.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+        simpleRenderSystem.impostorBodies = config.impostorBodies;
+        LveCamera camera{};
+        const float frameTime = scene.frameDelta * config.stepsPerFrame;
+
+        std::cout << config.scenePath << ": " << scene.bodies.size() << " bodies, " << config.frames << " frames of "
+                  << config.extent.width << "x" << config.extent.height << " to " << frameOutputName(config.output)
+                  << " output " << config.target << "\n";
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < config.frames; frame++) {
+            for (uint32_t step = 0; step < config.stepsPerFrame; step++) {
+                physicsSystem.update(scene.bodies, scene.frameDelta, scene.substeps);
+            }
+            syncGameObjects();
+
+            const auto centerOfMass = physicsSystem.getCenterOfMass();
+            camera.setViewYXZ(
+                glm::vec3{ centerOfMass[0], centerOfMass[1], centerOfMass[2] - config.cameraDistance },
+                glm::vec3{ 0.f });
+            camera.setPerspectiveProjection(glm::radians(45.f), renderer.getAspectRatio(), 0.1f, 100.f);
+            simpleRenderSystem.selectCircleLods(camera, static_cast<float>(config.extent.height), bodyObjects);
+
+            // waits, if at all, for the frame of this slot FRAMES_IN_FLIGHT frames ago and writes it out
+            VkCommandBuffer commandBuffer = renderer.beginFrame();
+            int frameIndex = renderer.getFrameIndex();
+            FrameInfo frameInfo{
+                frameIndex,
+                frameTime,
+                commandBuffer,
+                camera,
+                globalDescriptorSets[frameIndex] };
+
+            GlobalUbo ubo{};
+            ubo.projection = camera.getProjection();
+            ubo.view = camera.getView();
+            ubo.projectionView = ubo.projection * ubo.view;
+            uboBuffers[frameIndex]->writeToBuffer(&ubo);
+
+            renderer.beginRenderPass(commandBuffer);
+            simpleRenderSystem.renderGameObjectsInstanced(frameInfo, { &bodyObjects });
+            renderer.endRenderPass(commandBuffer);
+            renderer.endFrame();
+        }
+        renderer.finish();
+        frameWriter.close();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        vkDeviceWaitIdle(lveDevice.device());
+
+        std::cout << frameWriter.getFramesWritten() << " frames in " << seconds << " s: "
+                  << frameWriter.getFramesWritten() / seconds << " frames/s, "
+                  << frameWriter.getBytesWritten() / seconds / (1024.0 * 1024.0) << " MiB/s written, "
+                  << renderer.getReadbackWaitSeconds() << " s waiting for the GPU\n";
+        std::cout << scene.bodies.size() << " bodies left\n";
+    }
+}  // namespace lve
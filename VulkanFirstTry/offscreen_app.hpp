@@ -0,0 +1,55 @@
+#pragma once
+
+#include "frame_writer.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "scene_loader.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+    struct OffscreenAppConfig {
+        std::string scenePath = "../scenes/three_bodies.scene";
+        uint32_t frames = 600;
+        uint32_t stepsPerFrame = 1;  // scene updates between two frames
+        VkExtent2D extent{ 1280, 720 };
+        FrameOutput output = FrameOutput::Ppm;
+        std::string target = "frames/frame_";  // file, file name prefix or encoder command, see FrameWriter
+        float cameraDistance = 3.f;            // behind the center of mass, like FirstApp's camera
+        bool impostorBodies = false;           // shaded sphere quads instead of circle meshes
+    };
+
+    // Steps a scene file and renders every step into an LveOffscreenRenderer on a headless device,
+    // streaming the frames to a FrameWriter. No window and no real time pacing: it goes as fast as
+    // the physics, the GPU and the output allow.
+    class OffscreenApp {
+    public:
+        OffscreenApp(const OffscreenAppConfig& config);
+        ~OffscreenApp();
+
+        OffscreenApp(const OffscreenApp&) = delete;
+        OffscreenApp& operator=(const OffscreenApp&) = delete;
+
+        void run();
+
+    private:
+        void loadGameObjects();
+        // moves the render objects to their bodies and drops the ones merged away
+        void syncGameObjects();
+
+        OffscreenAppConfig config;
+        SceneDescription scene;
+        LveDevice lveDevice{};
+
+        // declared after the device so it is destroyed before it
+        std::unique_ptr<LveDescriptorPool> globalPool{};
+
+        std::shared_ptr<LveModel> circleModel;
+        std::vector<LveGameObject> bodyObjects;
+    };
+}  // namespace lve
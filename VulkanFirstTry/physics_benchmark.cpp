@@ -0,0 +1,245 @@
+#include "physics_benchmark.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <thread>
+
+namespace lve {
+
+    BodyStore makeRandomScene(size_t count, uint32_t seed) {
+        BodyStore bodies{};
+        if (count == 0) return bodies;
+        bodies.reserve(count);
+
+        std::mt19937 rng{ seed };
+        std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+        const float pi = 3.14159265f;
+
+        const float centralMass = 10.0f;
+        bodies.add(0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, centralMass, 0.05f, 1.0f, 0.9f, 0.3f);
+        for (size_t i = 1; i < count; i++) {
+            const float angle = 2.0f * pi * unit(rng);
+            const float distance = 1.0f + 9.0f * unit(rng);
+            const float height = 0.2f * (unit(rng) - 0.5f);
+            // circular orbit around the central body at G = 1 and unit scale 1
+            const float speed = std::sqrt(centralMass / distance);
+            bodies.add(
+                static_cast<BodyStore::id_t>(i),
+                distance * std::cos(angle),
+                height,
+                distance * std::sin(angle),
+                -speed * std::sin(angle),
+                0.0f,
+                speed * std::cos(angle),
+                0.0001f + 0.001f * unit(rng),
+                0.0005f,
+                unit(rng),
+                unit(rng),
+                unit(rng));
+        }
+        return bodies;
+    }
+
+    static bool sameState(const BodyStore& a, const BodyStore& b) {
+        if (a.size() != b.size()) return false;
+        const size_t bytes = a.size() * sizeof(float);
+        return std::memcmp(a.x.data(), b.x.data(), bytes) == 0 && std::memcmp(a.y.data(), b.y.data(), bytes) == 0 &&
+            std::memcmp(a.z.data(), b.z.data(), bytes) == 0 && std::memcmp(a.vx.data(), b.vx.data(), bytes) == 0 &&
+            std::memcmp(a.vy.data(), b.vy.data(), bytes) == 0 && std::memcmp(a.vz.data(), b.vz.data(), bytes) == 0;
+    }
+
+    std::vector<ScalingSample> runStrongScalingBenchmark(const ScalingBenchmarkSettings& settings) {
+        const unsigned int maxThreads = settings.maxThreads > 0
+            ? settings.maxThreads
+            : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned int> threadCounts;
+        for (unsigned int t = 1; t < maxThreads; t *= 2) {
+            threadCounts.push_back(t);
+        }
+        threadCounts.push_back(maxThreads);
+
+        const BodyStore scene = makeRandomScene(settings.bodyCount, settings.seed);
+        const float dt = 1.0f / 60;
+        std::vector<ScalingSample> samples;
+        BodyStore reference{};
+
+        for (const unsigned int threads : threadCounts) {
+            PhysicsSystem physics{ 1.0f, 1.0f, threads };
+            physics.solver = settings.solver;
+            BodyStore bodies = scene;
+
+            const auto start = std::chrono::steady_clock::now();
+            for (unsigned int step = 0; step < settings.steps; step++) {
+                physics.update(bodies, dt);
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            ScalingSample sample{};
+            sample.threads = threads;
+            sample.millisecondsPerStep =
+                std::chrono::duration<double, std::milli>(end - start).count() / std::max(1u, settings.steps);
+            if (samples.empty()) {
+                reference = bodies;
+                sample.speedup = 1.0;
+                sample.identical = true;
+            }
+            else {
+                sample.speedup = samples.front().millisecondsPerStep / sample.millisecondsPerStep;
+                sample.identical = sameState(reference, bodies);
+            }
+            sample.efficiency = sample.speedup / threads;
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    void printScalingResults(
+        const ScalingBenchmarkSettings& settings, const std::vector<ScalingSample>& samples, std::ostream& out) {
+        out << "Strong scaling, " << settings.bodyCount << " bodies, " << settings.steps << " steps, "
+            << solverName(settings.solver) << "\n";
+        out << std::setw(8) << "threads" << std::setw(12) << "ms/step" << std::setw(10) << "speedup"
+            << std::setw(12) << "efficiency" << std::setw(11) << "identical" << "\n";
+        out << std::fixed;
+        for (const ScalingSample& sample : samples) {
+            out << std::setw(8) << sample.threads << std::setw(12) << std::setprecision(2)
+                << sample.millisecondsPerStep << std::setw(10) << sample.speedup << std::setw(11)
+                << std::setprecision(0) << sample.efficiency * 100.0 << "%" << std::setw(11)
+                << (sample.identical ? "yes" : "NO") << "\n";
+        }
+        out << std::defaultfloat << std::flush;
+    }
+
+    std::vector<FmmSample> runFmmBenchmark(const FmmBenchmarkSettings& settings) {
+        ThreadPool pool{ settings.threads };
+        const SimdLevel simdLevel = detectSimdLevel();
+        const DirectKernel kernel = selectDirectKernel(simdLevel);
+        std::vector<FmmSample> samples;
+
+        for (const size_t count : settings.bodyCounts) {
+            const BodyStore bodies = makeRandomScene(count, settings.seed);
+            FmmSample sample{};
+            sample.bodyCount = count;
+
+            FmmSolver fmm{};
+            const auto fmmStart = std::chrono::steady_clock::now();
+            fmm.evaluate(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.radius.data(),
+                count, settings.order, simdLevel, pool);
+            const auto fmmEnd = std::chrono::steady_clock::now();
+            sample.fmmMilliseconds = std::chrono::duration<double, std::milli>(fmmEnd - fmmStart).count();
+            sample.depth = fmm.depth();
+
+            const size_t targets = std::min(count, std::max<size_t>(settings.directSampleSize, 1));
+            const size_t stride = count / targets;
+            sample.directExtrapolated = targets < count;
+            std::vector<float> directX(targets), directY(targets), directZ(targets);
+            const GravitySources sources{
+                bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.radius.data() };
+            const auto directStart = std::chrono::steady_clock::now();
+            pool.parallelFor(targets, 16, [&](size_t begin, size_t end) {
+                for (size_t t = begin; t < end; t++) {
+                    const size_t i = t * stride;
+                    float a[3];
+                    kernel(sources, 0, count, bodies.x[i], bodies.y[i], bodies.z[i], bodies.radius[i], a);
+                    directX[t] = a[0];
+                    directY[t] = a[1];
+                    directZ[t] = a[2];
+                }
+            });
+            const auto directEnd = std::chrono::steady_clock::now();
+            sample.directMilliseconds = std::chrono::duration<double, std::milli>(directEnd - directStart).count() *
+                static_cast<double>(count) / targets;
+
+            double errorSquared = 0.0;
+            double referenceSquared = 0.0;
+            for (size_t t = 0; t < targets; t++) {
+                const size_t i = t * stride;
+                const double ex = fmm.accelX()[i] - directX[t];
+                const double ey = fmm.accelY()[i] - directY[t];
+                const double ez = fmm.accelZ()[i] - directZ[t];
+                errorSquared += ex * ex + ey * ey + ez * ez;
+                referenceSquared += static_cast<double>(directX[t]) * directX[t] +
+                    static_cast<double>(directY[t]) * directY[t] + static_cast<double>(directZ[t]) * directZ[t];
+            }
+            sample.rmsRelativeError = referenceSquared > 0.0 ? std::sqrt(errorSquared / referenceSquared) : 0.0;
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    void printFmmResults(const FmmBenchmarkSettings& settings, const std::vector<FmmSample>& samples, std::ostream& out) {
+        out << "FMM order " << settings.order << " against direct summation (* extrapolated from "
+            << settings.directSampleSize << " targets)\n";
+        out << std::setw(10) << "bodies" << std::setw(7) << "depth" << std::setw(12) << "fmm ms" << std::setw(14)
+            << "direct ms" << std::setw(10) << "speedup" << std::setw(12) << "rms error" << "\n";
+        for (const FmmSample& sample : samples) {
+            out << std::setw(10) << sample.bodyCount << std::setw(7) << sample.depth << std::fixed
+                << std::setprecision(1) << std::setw(12) << sample.fmmMilliseconds << std::setw(13)
+                << sample.directMilliseconds << (sample.directExtrapolated ? "*" : " ") << std::setw(10)
+                << sample.directMilliseconds / sample.fmmMilliseconds << std::scientific << std::setprecision(2)
+                << std::setw(12) << sample.rmsRelativeError << std::defaultfloat << "\n";
+        }
+        out << std::flush;
+    }
+
+    std::vector<IntegratorSample> runIntegratorBenchmark(const IntegratorBenchmarkSettings& settings) {
+        // near test-particle disc: close encounters and merges would swamp the integration error
+        BodyStore scene = makeRandomScene(settings.bodyCount, settings.seed);
+        for (size_t i = 1; i < scene.size(); i++) {
+            scene.mass[i] *= 1e-4f;
+        }
+        const Integrator integrators[] = {
+            Integrator::SemiImplicitEuler, Integrator::Leapfrog, Integrator::Yoshida4, Integrator::AdaptiveBlock };
+        const unsigned int substepCounts[] = { 1, 5 };
+
+        std::vector<IntegratorSample> samples;
+        for (const Integrator integrator : integrators) {
+            for (const unsigned int substeps : substepCounts) {
+                PhysicsSystem physics{ 1.0f, 1.0f };
+                physics.integrator = integrator;
+                physics.precision = settings.precision;
+                BodyStore bodies = scene;
+                const double startEnergy = physics.computeTotalEnergy(bodies);
+
+                size_t evaluations = 0;
+                const auto start = std::chrono::steady_clock::now();
+                for (unsigned int frame = 0; frame < settings.frames; frame++) {
+                    physics.update(bodies, settings.frameDelta, substeps);
+                    evaluations += physics.getForceEvaluations();
+                }
+                const auto end = std::chrono::steady_clock::now();
+
+                IntegratorSample sample{};
+                sample.integrator = integrator;
+                sample.substeps = substeps;
+                sample.forceEvaluationsPerFrame = static_cast<double>(evaluations) / std::max(1u, settings.frames);
+                sample.relativeEnergyError =
+                    std::fabs(physics.computeTotalEnergy(bodies) - startEnergy) / std::fabs(startEnergy);
+                sample.millisecondsPerFrame =
+                    std::chrono::duration<double, std::milli>(end - start).count() / std::max(1u, settings.frames);
+                samples.push_back(sample);
+            }
+        }
+        return samples;
+    }
+
+    void printIntegratorResults(
+        const IntegratorBenchmarkSettings& settings, const std::vector<IntegratorSample>& samples, std::ostream& out) {
+        out << "Integrators, " << settings.bodyCount << " bodies, " << settings.frames << " frames, "
+            << precisionName(settings.precision) << " precision\n";
+        out << std::setw(20) << "integrator" << std::setw(10) << "substeps" << std::setw(14) << "evals/frame"
+            << std::setw(14) << "energy error" << std::setw(12) << "ms/frame" << "\n";
+        for (const IntegratorSample& sample : samples) {
+            out << std::setw(20) << integratorName(sample.integrator) << std::setw(10) << sample.substeps
+                << std::fixed << std::setprecision(0) << std::setw(14) << sample.forceEvaluationsPerFrame
+                << std::scientific << std::setprecision(2) << std::setw(14) << sample.relativeEnergyError
+                << std::fixed << std::setw(12) << sample.millisecondsPerFrame << "\n";
+        }
+        out << std::defaultfloat << std::flush;
+    }
+
+}  // namespace lve
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "body_store.hpp"
+#include "physics_system.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lve {
+    struct ScalingSample {
+        unsigned int threads{};
+        double millisecondsPerStep{};
+        double speedup{};     // against the single thread run
+        double efficiency{};  // speedup / threads
+        bool identical{};     // final state bit-identical to the single thread run
+    };
+
+    struct ScalingBenchmarkSettings {
+        size_t bodyCount{ 20000 };
+        unsigned int steps{ 10 };
+        unsigned int maxThreads{ 0 };  // 0 uses every hardware thread
+        GravitySolver solver{ GravitySolver::DirectSum };
+        uint32_t seed{ 1 };
+    };
+
+    struct IntegratorSample {
+        Integrator integrator{};
+        unsigned int substeps{};
+        double forceEvaluationsPerFrame{};
+        double relativeEnergyError{};  // |E_end - E_start| / |E_start|
+        double millisecondsPerFrame{};
+    };
+
+    struct IntegratorBenchmarkSettings {
+        size_t bodyCount{ 500 };
+        unsigned int frames{ 600 };
+        float frameDelta{ 1.0f / 60 };
+        Precision precision{ Precision::Single };
+        uint32_t seed{ 1 };
+    };
+
+    struct FmmSample {
+        size_t bodyCount{};
+        int depth{};
+        double fmmMilliseconds{};
+        double directMilliseconds{};
+        bool directExtrapolated{};  // timed on directSampleSize targets and scaled up
+        // |a_fmm - a_direct| over |a_direct|, both summed in quadrature over the sampled targets, so a
+        // body whose pulls nearly cancel out (the central one) does not swamp the figure
+        double rmsRelativeError{};
+    };
+
+    struct FmmBenchmarkSettings {
+        std::vector<size_t> bodyCounts{ 10000, 100000, 1000000 };
+        int order{ 4 };
+        size_t directSampleSize{ 2000 };
+        unsigned int threads{ 0 };
+        uint32_t seed{ 1 };
+    };
+
+    // Random disc of small bodies around a heavy central one, the same shape as the demo scene.
+    BodyStore makeRandomScene(size_t count, uint32_t seed);
+
+    // Strong scaling: the same scene stepped at 1, 2, 4, ... threads and finally maxThreads.
+    std::vector<ScalingSample> runStrongScalingBenchmark(const ScalingBenchmarkSettings& settings);
+    void printScalingResults(
+        const ScalingBenchmarkSettings& settings, const std::vector<ScalingSample>& samples, std::ostream& out);
+
+    // Time per force evaluation of the FMM against direct summation. Direct sums above
+    // directSampleSize bodies are timed on an evenly strided sample of targets and extrapolated.
+    std::vector<FmmSample> runFmmBenchmark(const FmmBenchmarkSettings& settings);
+    void printFmmResults(const FmmBenchmarkSettings& settings, const std::vector<FmmSample>& samples, std::ostream& out);
+
+    // Energy drift against force evaluations for every integrator at a few substep counts.
+    std::vector<IntegratorSample> runIntegratorBenchmark(const IntegratorBenchmarkSettings& settings);
+    void printIntegratorResults(
+        const IntegratorBenchmarkSettings& settings, const std::vector<IntegratorSample>& samples, std::ostream& out);
+}  // namespace lve
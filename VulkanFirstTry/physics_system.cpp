@@ -0,0 +1,668 @@
+#include "physics_system.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace lve {
+
+    void PhysicsSystem::update(BodyStore& bodies, float dt, unsigned int substeps) {
+        // switching precision hands the state over between the float and double arrays
+        if (precision != Precision::Single && !bodies.hasDoubleState()) {
+            bodies.enableDoubleState();
+            accelerationsValid = false;
+        }
+        else if (precision == Precision::Single && bodies.hasDoubleState()) {
+            bodies.disableDoubleState();
+            accelerationsValid = false;
+        }
+
+        // merges keep the total mass, only added or removed bodies change it
+        if (!totalMassValid || bodies.size() != massBodyCount) {
+            double mass = 0.0;
+            for (size_t i = 0; i < bodies.size(); i++) {
+                mass += bodies.mass[i];
+            }
+            totalMass = static_cast<float>(mass);
+            totalMassValid = true;
+            massBodyCount = bodies.size();
+        }
+
+        forceEvaluations = 0;
+        const float stepDelta = dt / substeps;
+        for (unsigned int i = 0; i < substeps; i++) {
+            stepSimulation(bodies, stepDelta);
+        }
+        // the only double to float conversion of the frame, the renderer reads the float arrays
+        bodies.syncFloatState();
+        if (forceErrorRegression) {
+            if (solver == GravitySolver::BarnesHut) {
+                std::cout << "Barnes-Hut theta " << openingAngle;
+            }
+            else if (solver == GravitySolver::FastMultipole) {
+                std::cout << "FMM order " << multipoleOrder << ", depth " << fmm.depth();
+            }
+            else {
+                std::cout << "Direct sum ("
+                    << (precision == Precision::Double ? "double" : simdLevelName(simdLevel)) << ")";
+            }
+            std::cout << ", " << lastForceError.bodyCount
+                << " bodies: max force error " << lastForceError.maxRelativeError
+                << ", rms " << lastForceError.rmsRelativeError << std::endl;
+        }
+    }
+
+    const char* solverName(GravitySolver solver) {
+        switch (solver) {
+        case GravitySolver::BarnesHut:
+            return "Barnes-Hut";
+        case GravitySolver::FastMultipole:
+            return "fast multipole";
+        default:
+            return "direct sum";
+        }
+    }
+
+    const char* integratorName(Integrator integrator) {
+        switch (integrator) {
+        case Integrator::Leapfrog:
+            return "leapfrog";
+        case Integrator::Yoshida4:
+            return "Yoshida 4";
+        case Integrator::AdaptiveBlock:
+            return "adaptive block";
+        default:
+            return "semi-implicit Euler";
+        }
+    }
+
+    const char* precisionName(Precision precision) {
+        switch (precision) {
+        case Precision::Double:
+            return "double";
+        case Precision::Mixed:
+            return "mixed";
+        default:
+            return "single";
+        }
+    }
+
+    // Fills the accelerations of the `activeCount` bodies listed in `active`, or of every body when
+    // `active` is null. Every body is a source either way. Single and Mixed write accelX/Y/Z,
+    // Double writes accelXd/Yd/Zd.
+    void PhysicsSystem::computeAccelerations(const BodyStore& bodies, const uint32_t* active, size_t activeCount) {
+        const size_t count = bodies.size();
+        if (active == nullptr) activeCount = count;
+        accelX.resize(count);
+        accelY.resize(count);
+        accelZ.resize(count);
+        forceEvaluations += activeCount;
+
+        const bool singlePrecision = precision == Precision::Single;
+        if (!singlePrecision) {
+            refreshRelativePositions(bodies);
+        }
+        const float* px = singlePrecision ? bodies.x.data() : relX.data();
+        const float* py = singlePrecision ? bodies.y.data() : relY.data();
+        const float* pz = singlePrecision ? bodies.z.data() : relZ.data();
+
+        if (precision == Precision::Double) {
+            accelXd.resize(count);
+            accelYd.resize(count);
+            accelZd.resize(count);
+        }
+
+        if (solver == GravitySolver::FastMultipole) {
+            // the expansions are built for every body anyway, only the active ones are taken
+            fmm.evaluate(px, py, pz, bodies.mass.data(), bodies.radius.data(), count, multipoleOrder, simdLevel, *pool);
+            for (size_t k = 0; k < activeCount; k++) {
+                const size_t i = active ? active[k] : k;
+                accelX[i] = fmm.accelX()[i];
+                accelY[i] = fmm.accelY()[i];
+                accelZ[i] = fmm.accelZ()[i];
+                if (precision == Precision::Double) {
+                    accelXd[i] = accelX[i];
+                    accelYd[i] = accelY[i];
+                    accelZd[i] = accelZ[i];
+                }
+            }
+        }
+        else if (solver == GravitySolver::BarnesHut) {
+            // Overlapping pairs exert no force on each other, like in the direct sum; they merge at
+            // the end of the substep
+            tree.build(px, py, pz, bodies.mass.data(), bodies.radius.data(), count);
+            // the tree is read-only while it is walked, one traversal per body
+            pool->parallelFor(activeCount, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    const uint32_t i = active ? active[k] : static_cast<uint32_t>(k);
+                    float a[3];
+                    tree.accelerationAt(px[i], py[i], pz[i], bodies.radius[i], i, openingAngle, a);
+                    accelX[i] = a[0];
+                    accelY[i] = a[1];
+                    accelZ[i] = a[2];
+                    if (precision == Precision::Double) {
+                        accelXd[i] = a[0];
+                        accelYd[i] = a[1];
+                        accelZd[i] = a[2];
+                    }
+                }
+            });
+        }
+        else if (precision == Precision::Double) {
+            const GravitySourcesDouble sources{
+                bodies.xd.data(), bodies.yd.data(), bodies.zd.data(), bodies.mass.data(), bodies.radius.data() };
+            pool->parallelFor(activeCount, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    const size_t i = active ? active[k] : k;
+                    double a[3];
+                    directAccelerationDouble(
+                        sources, 0, count, bodies.xd[i], bodies.yd[i], bodies.zd[i], bodies.radius[i], a);
+                    accelXd[i] = a[0];
+                    accelYd[i] = a[1];
+                    accelZd[i] = a[2];
+                }
+            });
+        }
+        else {
+            const DirectKernel kernel = selectDirectKernel(simdLevel);
+            const GravitySources sources{ px, py, pz, bodies.mass.data(), bodies.radius.data() };
+            // each body's sum runs over all sources in a fixed order, so the tiling cannot change it
+            pool->parallelFor(activeCount, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    const size_t i = active ? active[k] : k;
+                    float a[3];
+                    kernel(sources, 0, count, px[i], py[i], pz[i], bodies.radius[i], a);
+                    accelX[i] = a[0];
+                    accelY[i] = a[1];
+                    accelZ[i] = a[2];
+                }
+            });
+        }
+
+        if (active == nullptr) {
+            accelerationsValid = true;
+            if (forceErrorRegression) {
+                lastForceError = measureForceError(bodies);
+            }
+        }
+    }
+
+    void PhysicsSystem::ensureAccelerations(const BodyStore& bodies) {
+        if (!accelerationsValid || accelX.size() != bodies.size()) {
+            computeAccelerations(bodies, nullptr, 0);
+        }
+    }
+
+    // Moves the floating origin to the center of mass of all bodies. Offsets from it stay small
+    // for a bound system, so float forces keep their relative precision wherever it sits.
+    void PhysicsSystem::recenterOrigin(const BodyStore& bodies) {
+        double sumMass = 0.0, sx = 0.0, sy = 0.0, sz = 0.0;
+        for (size_t i = 0; i < bodies.size(); i++) {
+            sumMass += bodies.mass[i];
+            sx += bodies.mass[i] * bodies.xd[i];
+            sy += bodies.mass[i] * bodies.yd[i];
+            sz += bodies.mass[i] * bodies.zd[i];
+        }
+        if (sumMass > 0.0) {
+            floatingOrigin = { sx / sumMass, sy / sumMass, sz / sumMass };
+        }
+    }
+
+    void PhysicsSystem::refreshRelativePositions(const BodyStore& bodies) {
+        const size_t count = bodies.size();
+        relX.resize(count);
+        relY.resize(count);
+        relZ.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            relX[i] = static_cast<float>(bodies.xd[i] - floatingOrigin[0]);
+            relY[i] = static_cast<float>(bodies.yd[i] - floatingOrigin[1]);
+            relZ[i] = static_cast<float>(bodies.zd[i] - floatingOrigin[2]);
+        }
+    }
+
+    void PhysicsSystem::accelerationOf(size_t body, double out[3]) const {
+        if (precision == Precision::Double) {
+            out[0] = accelXd[body];
+            out[1] = accelYd[body];
+            out[2] = accelZd[body];
+        }
+        else {
+            out[0] = accelX[body];
+            out[1] = accelY[body];
+            out[2] = accelZ[body];
+        }
+    }
+
+    // Broad phase on the spatial hash, then every overlapping group is merged into its lowest index
+    // body in ascending order and the absorbed bodies are dropped in one compaction. A chain where
+    // a touches b and b touches c merges all three even if a and c are apart.
+    void PhysicsSystem::mergeOverlapping(BodyStore& bodies) {
+        const size_t count = bodies.size();
+        mergeMoments = {};
+        if (precision == Precision::Single) {
+            broadPhase.build(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.radius.data(), count);
+        }
+        else {
+            refreshRelativePositions(bodies);
+            broadPhase.build(relX.data(), relY.data(), relZ.data(), bodies.radius.data(), count);
+        }
+
+        tilePairs.resize((count + FORCE_TILE_SIZE - 1) / FORCE_TILE_SIZE);
+        pool->parallelFor(count, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+            std::vector<SpatialHash::Pair>& pairs = tilePairs[begin / FORCE_TILE_SIZE];
+            pairs.clear();
+            for (size_t i = begin; i < end; i++) {
+                broadPhase.overlapsOf(static_cast<uint32_t>(i), pairs);
+            }
+        });
+
+        bool anyPair = false;
+        for (const auto& pairs : tilePairs) {
+            anyPair = anyPair || !pairs.empty();
+        }
+        if (!anyPair) return;
+
+        mergeRoot.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            mergeRoot[i] = i;
+        }
+        for (const auto& pairs : tilePairs) {
+            for (const SpatialHash::Pair& pair : pairs) {
+                const uint32_t a = findMergeRoot(pair.first);
+                const uint32_t b = findMergeRoot(pair.second);
+                if (a < b) mergeRoot[b] = a;
+                else if (b < a) mergeRoot[a] = b;
+            }
+        }
+
+        mergedAway.assign(count, 0);
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t root = findMergeRoot(i);
+            if (root == i) continue;
+            // swap the two bodies' share of the moments gathered before the merge for the result's
+            addMoments(bodies, root, -1.0, mergeMoments);
+            addMoments(bodies, i, -1.0, mergeMoments);
+            bodies.merge(root, i);
+            addMoments(bodies, root, 1.0, mergeMoments);
+            mergedAway[i] = 1;
+        }
+        bodies.compact(mergedAway);
+        massBodyCount = bodies.size();
+        // merged bodies moved and changed mass, the leapfrog integrators have to re-evaluate
+        accelerationsValid = false;
+    }
+
+    uint32_t PhysicsSystem::findMergeRoot(uint32_t body) {
+        while (mergeRoot[body] != body) {
+            mergeRoot[body] = mergeRoot[mergeRoot[body]];
+            body = mergeRoot[body];
+        }
+        return body;
+    }
+
+    // Velocity kick from the current accelerations, which are in scene units: converted with the
+    // gravity constant and unit scale they equal strengthGravity * m / (distance * unitScale)^2.
+    void PhysicsSystem::kickBody(BodyStore& bodies, size_t body, float dt) {
+        if (!bodies.hasDoubleState()) {
+            const float accelerationScale = strengthGravity / (unitScale * unitScale);
+            bodies.vx[body] += dt * accelerationScale * accelX[body];
+            bodies.vy[body] += dt * accelerationScale * accelY[body];
+            bodies.vz[body] += dt * accelerationScale * accelZ[body];
+            return;
+        }
+        const double scale = static_cast<double>(dt) * strengthGravity / (static_cast<double>(unitScale) * unitScale);
+        double a[3];
+        accelerationOf(body, a);
+        bodies.vxd[body] += scale * a[0];
+        bodies.vyd[body] += scale * a[1];
+        bodies.vzd[body] += scale * a[2];
+    }
+
+    void PhysicsSystem::kick(BodyStore& bodies, float dt, bool closing) {
+        if (closing) {
+            tileMoments.assign((bodies.size() + FORCE_TILE_SIZE - 1) / FORCE_TILE_SIZE, {});
+        }
+        pool->parallelFor(bodies.size(), FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                kickBody(bodies, i, dt);
+                if (closing) addMoments(bodies, i, 1.0, tileMoments[begin / FORCE_TILE_SIZE]);
+            }
+        });
+    }
+
+    void PhysicsSystem::drift(BodyStore& bodies, float dt) {
+        if (bodies.hasDoubleState()) {
+            const double step = static_cast<double>(dt) / unitScale;
+            for (size_t i = 0; i < bodies.size(); i++) {
+                bodies.xd[i] += step * bodies.vxd[i];
+                bodies.yd[i] += step * bodies.vyd[i];
+                bodies.zd[i] += step * bodies.vzd[i];
+            }
+        }
+        else {
+            for (size_t i = 0; i < bodies.size(); i++) {
+                bodies.x[i] += dt * (bodies.vx[i] / unitScale);
+                bodies.y[i] += dt * (bodies.vy[i] / unitScale);
+                bodies.z[i] += dt * (bodies.vz[i] / unitScale);
+            }
+        }
+        accelerationsValid = false;
+    }
+
+    // Semi-implicit Euler in one parallel sweep, which also gathers the mass moments.
+    void PhysicsSystem::kickDrift(BodyStore& bodies, float dt) {
+        tileMoments.assign((bodies.size() + FORCE_TILE_SIZE - 1) / FORCE_TILE_SIZE, {});
+        const bool doubles = bodies.hasDoubleState();
+        const double step = static_cast<double>(dt) / unitScale;
+        pool->parallelFor(bodies.size(), FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+            MassMoments& moments = tileMoments[begin / FORCE_TILE_SIZE];
+            for (size_t i = begin; i < end; i++) {
+                kickBody(bodies, i, dt);
+                if (doubles) {
+                    bodies.xd[i] += step * bodies.vxd[i];
+                    bodies.yd[i] += step * bodies.vyd[i];
+                    bodies.zd[i] += step * bodies.vzd[i];
+                }
+                else {
+                    bodies.x[i] += dt * (bodies.vx[i] / unitScale);
+                    bodies.y[i] += dt * (bodies.vy[i] / unitScale);
+                    bodies.z[i] += dt * (bodies.vz[i] / unitScale);
+                }
+                addMoments(bodies, i, 1.0, moments);
+            }
+        });
+        accelerationsValid = false;
+    }
+
+    // Kick-drift-kick. The closing force evaluation is reused for the opening kick of the next
+    // step, so a step costs one evaluation per body.
+    void PhysicsSystem::leapfrogStep(BodyStore& bodies, float dt, bool closing) {
+        ensureAccelerations(bodies);
+        kick(bodies, 0.5f * dt);
+        drift(bodies, dt);
+        computeAccelerations(bodies, nullptr, 0);
+        kick(bodies, 0.5f * dt, closing);
+    }
+
+    // Yoshida's fourth order composition of three leapfrog steps, the middle one runs backwards.
+    void PhysicsSystem::yoshidaStep(BodyStore& bodies, float dt) {
+        const double cubeRootTwo = std::cbrt(2.0);
+        const float w1 = static_cast<float>(1.0 / (2.0 - cubeRootTwo));
+        const float w0 = static_cast<float>(-cubeRootTwo / (2.0 - cubeRootTwo));
+        leapfrogStep(bodies, w1 * dt, false);
+        leapfrogStep(bodies, w0 * dt, false);
+        leapfrogStep(bodies, w1 * dt);
+    }
+
+    // Level of the largest power-of-two fraction of dt that satisfies
+    // step <= accuracy * sqrt(length / |a|), with |a| the positional acceleration in scene units.
+    unsigned int PhysicsSystem::timestepLevelFor(size_t body, float dt) const {
+        const float accelerationScale = strengthGravity / (unitScale * unitScale * unitScale);
+        double acceleration[3];
+        accelerationOf(body, acceleration);
+        const float a = accelerationScale * static_cast<float>(std::sqrt(acceleration[0] * acceleration[0] +
+            acceleration[1] * acceleration[1] + acceleration[2] * acceleration[2]));
+        if (!(a > 0.0f)) return 0;
+        const float wanted = timestepAccuracy * std::sqrt(timestepLength / a);
+        unsigned int level = 0;
+        for (float step = dt; step > wanted && level < maxTimestepLevel; step *= 0.5f) {
+            level++;
+        }
+        return level;
+    }
+
+    // Hierarchical kick-drift-kick on power-of-two block timesteps. The substep is split into
+    // 2^maxTimestepLevel ticks and a body on level k is kicked every 2^(maxTimestepLevel - k) ticks.
+    // All bodies drift together between events, but only the bodies whose step ends get a force
+    // evaluation. A body may move to a finer level at the end of any of its steps and to a coarser
+    // one only where that level's steps line up; at the end of the substep everybody is in sync.
+    void PhysicsSystem::blockTimestepStep(BodyStore& bodies, float dt) {
+        assert(maxTimestepLevel < 31 && "Block timestep level out of range");
+        ensureAccelerations(bodies);
+        const size_t count = bodies.size();
+        const uint32_t ticks = 1u << maxTimestepLevel;
+        const float tick = dt / ticks;
+
+        std::array<size_t, 32> levelCount{};
+        timestepLevel.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            timestepLevel[i] = static_cast<uint8_t>(timestepLevelFor(i, dt));
+            levelCount[timestepLevel[i]]++;
+            kickBody(bodies, i, 0.5f * (ticks >> timestepLevel[i]) * tick);
+        }
+
+        uint32_t now = 0;
+        while (now < ticks) {
+            uint32_t next = ticks;
+            for (unsigned int level = 0; level <= maxTimestepLevel; level++) {
+                if (levelCount[level] == 0) continue;
+                const uint32_t span = ticks >> level;
+                next = std::min(next, (now / span + 1) * span);
+            }
+            drift(bodies, (next - now) * tick);
+            now = next;
+
+            activeBodies.clear();
+            for (uint32_t i = 0; i < count; i++) {
+                if (now % (ticks >> timestepLevel[i]) == 0) activeBodies.push_back(i);
+            }
+            computeAccelerations(bodies, activeBodies.data(), activeBodies.size());
+
+            // the last tick kicks every body in order, its sweep gathers the mass moments
+            if (now == ticks) tileMoments.assign(1, {});
+            for (const uint32_t i : activeBodies) {
+                float halfStep = 0.5f * (ticks >> timestepLevel[i]) * tick;
+                if (now < ticks) {
+                    // closing kick of this step plus the opening kick of the next one
+                    unsigned int level = timestepLevelFor(i, dt);
+                    while (level < timestepLevel[i] && now % (ticks >> level) != 0) {
+                        level++;
+                    }
+                    levelCount[timestepLevel[i]]--;
+                    levelCount[level]++;
+                    timestepLevel[i] = static_cast<uint8_t>(level);
+                    halfStep += 0.5f * (ticks >> level) * tick;
+                }
+                kickBody(bodies, i, halfStep);
+                if (now == ticks) addMoments(bodies, i, 1.0, tileMoments[0]);
+            }
+        }
+        // every body was active on the last tick
+        accelerationsValid = true;
+    }
+
+    // Kinetic plus pairwise potential energy in physical units, overlapping pairs excluded like in
+    // the force sum. Each body sums the pairs above it in parallel, the partials are added in order.
+    double PhysicsSystem::computeTotalEnergy(const BodyStore& bodies) const {
+        const size_t count = bodies.size();
+        const bool doubles = bodies.hasDoubleState();
+        const auto posX = [&](size_t i) { return doubles ? bodies.xd[i] : static_cast<double>(bodies.x[i]); };
+        const auto posY = [&](size_t i) { return doubles ? bodies.yd[i] : static_cast<double>(bodies.y[i]); };
+        const auto posZ = [&](size_t i) { return doubles ? bodies.zd[i] : static_cast<double>(bodies.z[i]); };
+        std::vector<double> partial(count);
+        pool->parallelFor(count, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                const double vx = doubles ? bodies.vxd[i] : bodies.vx[i];
+                const double vy = doubles ? bodies.vyd[i] : bodies.vy[i];
+                const double vz = doubles ? bodies.vzd[i] : bodies.vz[i];
+                const double v2 = vx * vx + vy * vy + vz * vz;
+                double potential = 0.0;
+                for (size_t j = i + 1; j < count; j++) {
+                    const double dx = posX(j) - posX(i);
+                    const double dy = posY(j) - posY(i);
+                    const double dz = posZ(j) - posZ(i);
+                    const double r2 = dx * dx + dy * dy + dz * dz;
+                    const double touch = static_cast<double>(bodies.radius[i]) + bodies.radius[j];
+                    if (r2 < touch * touch || r2 == 0.0) continue;
+                    potential += bodies.mass[j] / std::sqrt(r2);
+                }
+                partial[i] = 0.5 * bodies.mass[i] * v2 -
+                    static_cast<double>(strengthGravity) * bodies.mass[i] * potential / unitScale;
+            }
+        });
+        double energy = 0.0;
+        for (const double e : partial) {
+            energy += e;
+        }
+        return energy;
+    }
+
+    // O(N^2) double precision reference for the current accelerations. Per-body errors are computed
+    // in parallel and summed in body order afterwards.
+    ForceErrorStats PhysicsSystem::measureForceError(const BodyStore& bodies) const {
+        const size_t count = bodies.size();
+        const bool doubles = bodies.hasDoubleState();
+        const auto posX = [&](size_t i) { return doubles ? bodies.xd[i] : static_cast<double>(bodies.x[i]); };
+        const auto posY = [&](size_t i) { return doubles ? bodies.yd[i] : static_cast<double>(bodies.y[i]); };
+        const auto posZ = [&](size_t i) { return doubles ? bodies.zd[i] : static_cast<double>(bodies.z[i]); };
+        std::vector<double> errors(count);
+        pool->parallelFor(count, FORCE_TILE_SIZE, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                double ax = 0.0, ay = 0.0, az = 0.0;
+                for (size_t j = 0; j < count; j++) {
+                    if (i == j) continue;
+                    const double dx = posX(j) - posX(i);
+                    const double dy = posY(j) - posY(i);
+                    const double dz = posZ(j) - posZ(i);
+                    const double r2 = dx * dx + dy * dy + dz * dz;
+                    const double touch = static_cast<double>(bodies.radius[i]) + bodies.radius[j];
+                    if (r2 < touch * touch || r2 == 0.0) continue;
+                    const double s = bodies.mass[j] / (r2 * std::sqrt(r2));
+                    ax += s * dx;
+                    ay += s * dy;
+                    az += s * dz;
+                }
+                const double reference = std::sqrt(ax * ax + ay * ay + az * az);
+                if (reference == 0.0) {
+                    errors[i] = -1.0;  // no net force, nothing to compare against
+                    continue;
+                }
+                double a[3];
+                accelerationOf(i, a);
+                const double ex = a[0] - ax;
+                const double ey = a[1] - ay;
+                const double ez = a[2] - az;
+                errors[i] = std::sqrt(ex * ex + ey * ey + ez * ez) / reference;
+            }
+        });
+
+        ForceErrorStats stats{};
+        double sumSquared = 0.0;
+        for (const double error : errors) {
+            if (error < 0.0) continue;
+            stats.maxRelativeError = std::max(stats.maxRelativeError, static_cast<float>(error));
+            sumSquared += error * error;
+            stats.bodyCount++;
+        }
+        if (stats.bodyCount > 0) {
+            stats.rmsRelativeError = static_cast<float>(std::sqrt(sumSquared / stats.bodyCount));
+        }
+        return stats;
+    }
+
+    // Adds sign times a body's mass, mass-weighted position and momentum to `moments`. Body 0 is
+    // the reference frame the center of mass velocity is measured in and is left out.
+    void PhysicsSystem::addMoments(const BodyStore& bodies, size_t body, double sign, MassMoments& moments) const {
+        if (body == 0) return;
+        const double m = sign * bodies.mass[body];
+        moments.mass += m;
+        if (bodies.hasDoubleState()) {
+            moments.position[0] += m * bodies.xd[body];
+            moments.position[1] += m * bodies.yd[body];
+            moments.position[2] += m * bodies.zd[body];
+            moments.momentum[0] += m * bodies.vxd[body];
+            moments.momentum[1] += m * bodies.vyd[body];
+            moments.momentum[2] += m * bodies.vzd[body];
+        }
+        else {
+            moments.position[0] += m * bodies.x[body];
+            moments.position[1] += m * bodies.y[body];
+            moments.position[2] += m * bodies.z[body];
+            moments.momentum[0] += m * bodies.vx[body];
+            moments.momentum[1] += m * bodies.vy[body];
+            moments.momentum[2] += m * bodies.vz[body];
+        }
+    }
+
+    // Center of mass of every body but body 0 from the moments the closing sweep gathered, added
+    // in tile order so the thread count cannot change the result, plus the merge corrections.
+    void PhysicsSystem::updateCenterOfMass(const BodyStore& bodies) {
+        const bool doubles = bodies.hasDoubleState();
+        const double velocity0[3] = {
+            doubles ? bodies.vxd[0] : bodies.vx[0],
+            doubles ? bodies.vyd[0] : bodies.vy[0],
+            doubles ? bodies.vzd[0] : bodies.vz[0] };
+        if (bodies.size() == 1) {
+            centerOfMass = {
+                doubles ? static_cast<float>(bodies.xd[0]) : bodies.x[0],
+                doubles ? static_cast<float>(bodies.yd[0]) : bodies.y[0],
+                doubles ? static_cast<float>(bodies.zd[0]) : bodies.z[0] };
+            centerOfMassVelocity = {};
+            totalMassStar = bodies.mass[0];
+            return;
+        }
+
+        MassMoments sum{};
+        for (const MassMoments& moments : tileMoments) {
+            sum.mass += moments.mass;
+            for (int k = 0; k < 3; k++) {
+                sum.position[k] += moments.position[k];
+                sum.momentum[k] += moments.momentum[k];
+            }
+        }
+        sum.mass += mergeMoments.mass;
+        for (int k = 0; k < 3; k++) {
+            sum.position[k] += mergeMoments.position[k];
+            sum.momentum[k] += mergeMoments.momentum[k];
+        }
+
+        // sum of m * (v0 - v) over the bodies, divided by their mass
+        for (int k = 0; k < 3; k++) {
+            centerOfMass[k] = static_cast<float>(sum.position[k] / sum.mass);
+            centerOfMassVelocity[k] = static_cast<float>(velocity0[k] - sum.momentum[k] / sum.mass);
+        }
+        totalMassStar = static_cast<float>(sum.mass);
+    }
+
+    float PhysicsSystem::getLorentzFactor(const BodyStore& bodies, size_t body) const {
+        constexpr double speedOfLight = 299792458.0;
+        const float share = (totalMass - bodies.mass[body]) / totalMass;
+        double speed2 = 0.0;
+        for (const float v : centerOfMassVelocity) {
+            const double metersPerSecond = share * v * 1000.0 * 10.0;
+            speed2 += metersPerSecond * metersPerSecond;
+        }
+        const double beta2 = speed2 / (speedOfLight * speedOfLight);
+        // a body's contracted radius would be radius / gamma
+        return beta2 < 1.0 ? static_cast<float>(1.0 / std::sqrt(1.0 - beta2)) : std::numeric_limits<float>::infinity();
+    }
+
+    void PhysicsSystem::stepSimulation(BodyStore& bodies, float dt) {
+        if (bodies.empty()) return;
+        if (precision != Precision::Single) {
+            recenterOrigin(bodies);
+        }
+
+        switch (integrator) {
+        case Integrator::Leapfrog:
+            leapfrogStep(bodies, dt);
+            break;
+        case Integrator::Yoshida4:
+            yoshidaStep(bodies, dt);
+            break;
+        case Integrator::AdaptiveBlock:
+            blockTimestepStep(bodies, dt);
+            break;
+        default:
+            computeAccelerations(bodies, nullptr, 0);
+            kickDrift(bodies, dt);
+            break;
+        }
+        mergeOverlapping(bodies);
+        updateCenterOfMass(bodies);
+    }
+
+}  // namespace lve
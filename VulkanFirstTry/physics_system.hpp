@@ -0,0 +1,167 @@
+#pragma once
+
+#include "barnes_hut.hpp"
+#include "body_store.hpp"
+#include "fmm.hpp"
+#include "gravity_kernels.hpp"
+#include "spatial_hash.hpp"
+#include "thread_pool.hpp"
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+    enum class GravitySolver {
+        DirectSum,
+        BarnesHut,
+        FastMultipole  // O(N), meant for large offline runs
+    };
+
+    const char* solverName(GravitySolver solver);
+
+    enum class Integrator {
+        SemiImplicitEuler,  // kick then drift, one force evaluation per substep
+        Leapfrog,           // kick-drift-kick, second order and symplectic
+        Yoshida4,           // three leapfrog steps, fourth order, three evaluations per substep
+        AdaptiveBlock       // leapfrog on per-body power-of-two timesteps
+    };
+
+    const char* integratorName(Integrator integrator);
+
+    enum class Precision {
+        Single,  // float state and forces
+        Double,  // double state and direct sum; the tree solvers still run on floats around the origin
+        Mixed    // double state, float SIMD forces on positions relative to a floating origin
+    };
+
+    const char* precisionName(Precision precision);
+
+    // Relative error of the approximate accelerations against an exact direct sum.
+    struct ForceErrorStats {
+        float maxRelativeError{};
+        float rmsRelativeError{};
+        size_t bodyCount{};
+    };
+
+    class PhysicsSystem {
+    public:
+        // bodies per force task; fixed so the work split, and the result, is the same at any thread count
+        static constexpr size_t FORCE_TILE_SIZE = 64;
+
+        PhysicsSystem(float gravity, float scale, unsigned int threadCount = 0)
+            : strengthGravity{ gravity }, unitScale{ scale }, pool{ std::make_unique<ThreadPool>(threadCount) } {}
+
+        PhysicsSystem(const PhysicsSystem&) = delete;
+        PhysicsSystem& operator=(const PhysicsSystem&) = delete;
+
+        const float strengthGravity;
+        const float unitScale;
+
+        GravitySolver solver{ GravitySolver::DirectSum };
+        float openingAngle{ 0.5f };  // Barnes-Hut theta, 0 degenerates to direct summation
+        int multipoleOrder{ 4 };  // FMM expansion order, up to FmmSolver::MAX_ORDER
+        SimdLevel simdLevel{ detectSimdLevel() };  // direct-sum kernel, lower it to force the scalar path
+        bool forceErrorRegression{ false };  // compare every substep against a double precision direct sum
+        ForceErrorStats lastForceError{};
+
+        Integrator integrator{ Integrator::SemiImplicitEuler };
+        // adaptive block timesteps: a body's step stays below accuracy * sqrt(length / |a|), with the
+        // length in scene units, and is halved at most maxTimestepLevel times per substep
+        float timestepAccuracy{ 0.2f };
+        float timestepLength{ 0.05f };
+        unsigned int maxTimestepLevel{ 8 };
+
+        // Double and Mixed keep positions and velocities in the store's double arrays and convert
+        // them to the float arrays once at the end of update()
+        Precision precision{ Precision::Single };
+
+        // The leapfrog integrators keep the last accelerations for the next opening kick and the
+        // total mass is only recounted when bodies are added or removed. Bodies are expected to
+        // change only through update(); call invalidateAccelerations() after editing them.
+        void update(BodyStore& bodies, float dt, unsigned int substeps = 1);
+        void invalidateAccelerations() {
+            accelerationsValid = false;
+            totalMassValid = false;
+        }
+
+        // kinetic plus potential energy in physical units, for checking integrator drift
+        double computeTotalEnergy(const BodyStore& bodies) const;
+        // per-body force evaluations done by the last update()
+        size_t getForceEvaluations() const { return forceEvaluations; }
+
+        // 0 uses every hardware thread, 1 runs the force phase on the calling thread only
+        void setThreadCount(unsigned int count) { pool = std::make_unique<ThreadPool>(count); }
+        unsigned int getThreadCount() const { return pool->threadCount(); }
+
+        // center of mass of every body but the first one, which the camera follows
+        std::array<float, 3> getCenterOfMass() const { return centerOfMass; }
+        std::array<float, 3> getCenterOfMassVelocity() const { return centerOfMassVelocity; }
+        float getTotalMass() const { return totalMass; }
+        // Lorentz factor of a body moving at its share of the center of mass velocity, taken as
+        // km/s and exaggerated tenfold so the effect shows. Computed on demand, nothing per substep.
+        float getLorentzFactor(const BodyStore& bodies, size_t body) const;
+        // center of mass of all bodies at the start of the last substep, float forces are evaluated
+        // on positions relative to it
+        std::array<double, 3> getFloatingOrigin() const { return floatingOrigin; }
+
+    private:
+        // mass moments of every body but the first, see getCenterOfMass()
+        struct MassMoments {
+            double mass{};
+            std::array<double, 3> position{};
+            std::array<double, 3> momentum{};
+        };
+
+        void stepSimulation(BodyStore& bodies, float dt);
+        void addMoments(const BodyStore& bodies, size_t body, double sign, MassMoments& moments) const;
+        void updateCenterOfMass(const BodyStore& bodies);
+        void leapfrogStep(BodyStore& bodies, float dt, bool closing = true);
+        void yoshidaStep(BodyStore& bodies, float dt);
+        void blockTimestepStep(BodyStore& bodies, float dt);
+        unsigned int timestepLevelFor(size_t body, float dt) const;
+
+        void computeAccelerations(const BodyStore& bodies, const uint32_t* active, size_t activeCount);
+        void ensureAccelerations(const BodyStore& bodies);
+        void recenterOrigin(const BodyStore& bodies);
+        void refreshRelativePositions(const BodyStore& bodies);
+        void accelerationOf(size_t body, double out[3]) const;
+        void kickBody(BodyStore& bodies, size_t body, float dt);
+        // `closing` marks the last sweep of a substep, which also gathers the mass moments
+        void kick(BodyStore& bodies, float dt, bool closing = false);
+        void drift(BodyStore& bodies, float dt);
+        void kickDrift(BodyStore& bodies, float dt);
+        void mergeOverlapping(BodyStore& bodies);
+        uint32_t findMergeRoot(uint32_t body);
+        ForceErrorStats measureForceError(const BodyStore& bodies) const;
+
+        std::array<float, 3> centerOfMass{};
+        std::array<float, 3> centerOfMassVelocity{};
+        float totalMassStar{};
+        float totalMass{};
+        bool totalMassValid{ false };
+        size_t massBodyCount{};
+        std::vector<MassMoments> tileMoments;  // one per FORCE_TILE_SIZE bodies, summed in tile order
+        MassMoments mergeMoments{};  // what the merges after the closing sweep changed
+
+        std::unique_ptr<ThreadPool> pool;
+        BarnesHutTree tree{};
+        FmmSolver fmm{};
+        std::vector<float> accelX, accelY, accelZ;
+        std::vector<double> accelXd, accelYd, accelZd;  // Double precision only
+        std::array<double, 3> floatingOrigin{};
+        std::vector<float> relX, relY, relZ;  // float positions around floatingOrigin
+        bool accelerationsValid{ false };
+        size_t forceEvaluations{};
+        std::vector<uint8_t> timestepLevel;
+        std::vector<uint32_t> activeBodies;
+
+        SpatialHash broadPhase{};
+        std::vector<std::vector<SpatialHash::Pair>> tilePairs;
+        std::vector<uint32_t> mergeRoot;  // union-find parent, a merge chain collapses into its lowest index
+        std::vector<uint8_t> mergedAway;
+    };
+}  // namespace lve
@@ -0,0 +1,123 @@
+#include "physics_thread.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+    PhysicsThread::PhysicsThread(
+        PhysicsSystem& system, BodyStore& bodies, float fixedStep, unsigned int substeps, float timeScale)
+        : system{ system }, bodies{ bodies }, fixedStep{ fixedStep }, substeps{ substeps }, timeScale{ timeScale } {}
+
+    PhysicsThread::~PhysicsThread() { stop(); }
+
+    void PhysicsThread::start() {
+        if (thread.joinable()) return;
+        stopping = false;
+        // the renderer gets the starting state before the first step is due
+        rememberPositions();
+        publish(std::chrono::steady_clock::now());
+        thread = std::thread(&PhysicsThread::run, this);
+    }
+
+    void PhysicsThread::stop() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock{ stopMutex };
+            stopping = true;
+        }
+        stopRequested.notify_all();
+        thread.join();
+    }
+
+    float PhysicsThread::interpolationFactor(
+        const PhysicsSnapshot& snapshot, std::chrono::steady_clock::time_point now) const {
+        const double elapsed = std::chrono::duration<double>(now - snapshot.stepWallTime).count();
+        return static_cast<float>(std::clamp(elapsed * timeScale / fixedStep, 0.0, 1.0));
+    }
+
+    void PhysicsThread::run() {
+        using clock = std::chrono::steady_clock;
+        auto lastTime = clock::now();
+        double accumulator = 0.0;  // simulated seconds not stepped yet
+
+        std::unique_lock<std::mutex> lock{ stopMutex };
+        while (!stopping) {
+            lock.unlock();
+            const auto now = clock::now();
+            accumulator += std::chrono::duration<double>(now - lastTime).count() * timeScale;
+            lastTime = now;
+
+            const unsigned int steps =
+                static_cast<unsigned int>(std::min<double>(accumulator / fixedStep, MAX_STEPS_PER_TICK));
+            for (unsigned int i = 0; i < steps; i++) {
+                if (i + 1 == steps) {
+                    rememberPositions();
+                }
+                system.update(bodies, fixedStep, substeps);
+                simulatedTime += fixedStep;
+                accumulator -= fixedStep;
+            }
+            if (accumulator >= fixedStep) {
+                droppedSeconds.store(
+                    droppedSeconds.load(std::memory_order_relaxed) + accumulator, std::memory_order_relaxed);
+                accumulator = 0.0;
+            }
+            if (steps > 0) {
+                stepCount.fetch_add(steps, std::memory_order_relaxed);
+                // the last step was due when the accumulator still held what is left of it now
+                publish(now - std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(accumulator / timeScale)));
+            }
+
+            const auto untilNextStep = std::chrono::duration<double>((fixedStep - accumulator) / timeScale);
+            lock.lock();
+            stopRequested.wait_for(lock, untilNextStep, [this] { return stopping; });
+        }
+    }
+
+    void PhysicsThread::rememberPositions() {
+        previousIds = bodies.ids;
+        previousX = bodies.x;
+        previousY = bodies.y;
+        previousZ = bodies.z;
+        previousCenterOfMass = system.getCenterOfMass();
+    }
+
+    void PhysicsThread::publish(std::chrono::steady_clock::time_point stepWallTime) {
+        PhysicsSnapshot& snapshot = snapshots.writeBuffer();
+        snapshot.ids = bodies.ids;
+        snapshot.x = bodies.x;
+        snapshot.y = bodies.y;
+        snapshot.z = bodies.z;
+        snapshot.radius = bodies.radius;
+        snapshot.colorR = bodies.colorR;
+        snapshot.colorG = bodies.colorG;
+        snapshot.colorB = bodies.colorB;
+        snapshot.centerOfMass = system.getCenterOfMass();
+        snapshot.previousCenterOfMass = previousCenterOfMass;
+
+        // merges only remove bodies and keep the order of the rest, so the same walk as for the
+        // render objects finds every body's previous position
+        const size_t count = bodies.size();
+        snapshot.previousX.resize(count);
+        snapshot.previousY.resize(count);
+        snapshot.previousZ.resize(count);
+        size_t previous = 0;
+        for (size_t body = 0; body < count; body++) {
+            while (previous < previousIds.size() && previousIds[previous] != bodies.ids[body]) {
+                previous++;
+            }
+            const bool found = previous < previousIds.size();
+            snapshot.previousX[body] = found ? previousX[previous] : bodies.x[body];
+            snapshot.previousY[body] = found ? previousY[previous] : bodies.y[body];
+            snapshot.previousZ[body] = found ? previousZ[previous] : bodies.z[body];
+        }
+
+        snapshot.time = simulatedTime;
+        snapshot.step = stepCount.load(std::memory_order_relaxed);
+        snapshot.stepWallTime = stepWallTime;
+        snapshots.publish();
+    }
+
+}  // namespace lve
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "body_store.hpp"
+#include "physics_system.hpp"
+#include "triple_buffer.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+    // What the renderer needs of the bodies after a physics step, plus where they were one step
+    // earlier so it can interpolate between the two.
+    struct PhysicsSnapshot {
+        std::vector<BodyStore::id_t> ids;
+        std::vector<float> x, y, z;
+        std::vector<float> previousX, previousY, previousZ;  // same order as ids
+        std::vector<float> radius;
+        std::vector<float> colorR, colorG, colorB;
+        std::array<float, 3> centerOfMass{};
+        std::array<float, 3> previousCenterOfMass{};
+
+        double time = 0.0;  // simulated seconds of x, y, z
+        uint64_t step = 0;  // 0 until the first step is published
+        // when the step was due in real time; the state is shown fully at one step after it
+        std::chrono::steady_clock::time_point stepWallTime{};
+    };
+
+    // Steps a PhysicsSystem on its own thread with a fixed timestep, independent of the frame rate.
+    //
+    // Real time is scaled by timeScale into an accumulator of simulated seconds, which is spent in
+    // steps of exactly fixedStep; the thread sleeps until the next step is due. After every batch of
+    // steps a snapshot goes out through a triple buffer, so the render loop never waits for physics
+    // and physics never waits for a frame, a minimised window or a swap chain rebuild. When steps
+    // fall behind by more than MAX_STEPS_PER_TICK the backlog is dropped rather than letting the
+    // simulation spiral, and counted in getDroppedSeconds().
+    class PhysicsThread {
+    public:
+        static constexpr unsigned int MAX_STEPS_PER_TICK = 8;
+
+        // bodies belong to the thread between start() and stop()
+        PhysicsThread(
+            PhysicsSystem& system, BodyStore& bodies, float fixedStep, unsigned int substeps, float timeScale);
+        ~PhysicsThread();
+
+        PhysicsThread(const PhysicsThread&) = delete;
+        PhysicsThread& operator=(const PhysicsThread&) = delete;
+
+        void start();
+        void stop();
+        bool isRunning() const { return thread.joinable(); }
+
+        // Reader side, for one thread only: takes the latest snapshot if there is a new one and
+        // returns whether it did. The snapshot stays valid until the next call.
+        bool pollSnapshot() { return snapshots.update(); }
+        const PhysicsSnapshot& getSnapshot() const { return snapshots.readBuffer(); }
+        // how far along from previousX to x the snapshot is at now, in [0, 1]
+        float interpolationFactor(const PhysicsSnapshot& snapshot, std::chrono::steady_clock::time_point now) const;
+
+        uint64_t getStepCount() const { return stepCount.load(std::memory_order_relaxed); }
+        double getDroppedSeconds() const { return droppedSeconds.load(std::memory_order_relaxed); }
+
+    private:
+        void run();
+        void rememberPositions();
+        void publish(std::chrono::steady_clock::time_point stepWallTime);
+
+        PhysicsSystem& system;
+        BodyStore& bodies;
+        const float fixedStep;
+        const unsigned int substeps;
+        const float timeScale;
+
+        std::thread thread;
+        std::mutex stopMutex;
+        std::condition_variable stopRequested;
+        bool stopping = false;
+
+        // the bodies before the last step of a tick
+        std::vector<BodyStore::id_t> previousIds;
+        std::vector<float> previousX, previousY, previousZ;
+        std::array<float, 3> previousCenterOfMass{};
+        double simulatedTime = 0.0;
+
+        TripleBuffer<PhysicsSnapshot> snapshots;
+        std::atomic<uint64_t> stepCount{ 0 };
+        std::atomic<double> droppedSeconds{ 0.0 };
+    };
+}  // namespace lve
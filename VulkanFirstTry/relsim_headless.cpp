@@ -0,0 +1,150 @@
+#include "physics_benchmark.hpp"
+#include "physics_system.hpp"
+#include "scene_loader.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// relsim-headless <scene> [--steps N] [--threads N] [--out file] [--energy]
+// runs the physics of a scene file without a window or GPU, one step being one update() of
+// dt split into the scene's substeps, and reports the throughput
+//
+// relsim-headless --bench-scaling | --bench-integrators | --bench-fmm [...]
+// runs one of the physics benchmarks instead of a scene
+static void printUsage() {
+    std::cerr << "usage: relsim-headless <scene> [--steps N] [--threads N] [--out file] [--energy]\n"
+              << "       relsim-headless --bench-scaling [bodies] [steps] [maxThreads] [bh|fmm]\n"
+              << "       relsim-headless --bench-integrators [bodies] [frames] [single|double|mixed]\n"
+              << "       relsim-headless --bench-fmm [order] [maxBodies]\n"
+              << "  --steps N    updates to run (default 600)\n"
+              << "  --threads N  force threads, 0 uses every hardware thread (default 0)\n"
+              << "  --out file   write the final state as a scene\n"
+              << "  --energy     report the total energy drift, costs two O(N^2) sums\n";
+}
+
+// relsim-headless --bench-scaling [bodies] [steps] [maxThreads] [bh|fmm]
+// runs the physics strong scaling benchmark
+static int runScalingBenchmark(int argc, char** argv) {
+    lve::ScalingBenchmarkSettings settings{};
+    if (argc > 2) settings.bodyCount = std::stoul(argv[2]);
+    if (argc > 3) settings.steps = static_cast<unsigned int>(std::stoul(argv[3]));
+    if (argc > 4) settings.maxThreads = static_cast<unsigned int>(std::stoul(argv[4]));
+    if (argc > 5 && std::string(argv[5]) == "bh") settings.solver = lve::GravitySolver::BarnesHut;
+    if (argc > 5 && std::string(argv[5]) == "fmm") settings.solver = lve::GravitySolver::FastMultipole;
+
+    const auto samples = lve::runStrongScalingBenchmark(settings);
+    lve::printScalingResults(settings, samples, std::cout);
+    return EXIT_SUCCESS;
+}
+
+// relsim-headless --bench-integrators [bodies] [frames] [single|double|mixed]
+// compares energy drift and force evaluations of the integrators
+static int runIntegratorBenchmark(int argc, char** argv) {
+    lve::IntegratorBenchmarkSettings settings{};
+    if (argc > 2) settings.bodyCount = std::stoul(argv[2]);
+    if (argc > 3) settings.frames = static_cast<unsigned int>(std::stoul(argv[3]));
+    if (argc > 4) {
+        const std::string precision = argv[4];
+        if (precision == "double") settings.precision = lve::Precision::Double;
+        else if (precision == "mixed") settings.precision = lve::Precision::Mixed;
+    }
+
+    const auto samples = lve::runIntegratorBenchmark(settings);
+    lve::printIntegratorResults(settings, samples, std::cout);
+    return EXIT_SUCCESS;
+}
+
+// relsim-headless --bench-fmm [order] [maxBodies]
+// times the FMM against direct summation from 10^4 bodies up to maxBodies
+static int runFmmBenchmark(int argc, char** argv) {
+    lve::FmmBenchmarkSettings settings{};
+    if (argc > 2) settings.order = std::stoi(argv[2]);
+    if (argc > 3) {
+        const size_t maxBodies = std::stoul(argv[3]);
+        settings.bodyCounts.clear();
+        for (size_t count = 10000; count <= maxBodies; count *= 10) {
+            settings.bodyCounts.push_back(count);
+        }
+    }
+
+    const auto samples = lve::runFmmBenchmark(settings);
+    lve::printFmmResults(settings, samples, std::cout);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const std::string mode = argv[1];
+        if (mode == "--bench-scaling") return runScalingBenchmark(argc, argv);
+        if (mode == "--bench-integrators") return runIntegratorBenchmark(argc, argv);
+        if (mode == "--bench-fmm") return runFmmBenchmark(argc, argv);
+
+        std::string scenePath;
+        std::string outPath;
+        unsigned int steps = 600;
+        unsigned int threads = 0;
+        bool reportEnergy = false;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--steps" && i + 1 < argc) steps = static_cast<unsigned int>(std::stoul(argv[++i]));
+            else if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+            else if (arg == "--energy") reportEnergy = true;
+            else if (scenePath.empty() && arg.rfind("--", 0) != 0) scenePath = arg;
+            else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        if (scenePath.empty()) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        lve::SceneDescription scene = lve::loadScene(scenePath);
+        lve::PhysicsSystem physics{ scene.gravity, scene.unitScale, threads };
+        scene.configure(physics);
+
+        const size_t initialBodies = scene.bodies.size();
+        const double initialEnergy = reportEnergy ? physics.computeTotalEnergy(scene.bodies) : 0.0;
+        std::cout << scenePath << ": " << initialBodies << " bodies, " << lve::integratorName(scene.integrator) << ", "
+                  << lve::precisionName(scene.precision) << " precision, " << physics.getThreadCount() << " threads\n";
+
+        size_t forceEvaluations = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned int step = 0; step < steps; step++) {
+            physics.update(scene.bodies, scene.frameDelta, scene.substeps);
+            forceEvaluations += physics.getForceEvaluations();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << steps << " steps in " << seconds << " s: " << steps / seconds << " steps/s, "
+                  << forceEvaluations / seconds << " force evaluations/s\n";
+        std::cout << scene.bodies.size() << " bodies left after " << initialBodies - scene.bodies.size() << " merges\n";
+        if (reportEnergy) {
+            const double finalEnergy = physics.computeTotalEnergy(scene.bodies);
+            std::cout << "energy " << initialEnergy << " -> " << finalEnergy << ", relative drift "
+                      << (initialEnergy != 0.0 ? (finalEnergy - initialEnergy) / initialEnergy : 0.0) << "\n";
+        }
+
+        if (!outPath.empty()) {
+            lve::saveScene(scene, outPath);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
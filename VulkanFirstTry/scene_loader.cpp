@@ -0,0 +1,173 @@
+#include "scene_loader.hpp"
+
+#include "physics_benchmark.hpp"
+
+// std
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+    void SceneDescription::configure(PhysicsSystem& physics) const {
+        physics.solver = solver;
+        physics.openingAngle = openingAngle;
+        physics.multipoleOrder = multipoleOrder;
+        physics.integrator = integrator;
+        physics.precision = precision;
+    }
+
+    static const char* solverKeyword(GravitySolver solver) {
+        switch (solver) {
+        case GravitySolver::BarnesHut:
+            return "barnes-hut";
+        case GravitySolver::FastMultipole:
+            return "fmm";
+        default:
+            return "direct";
+        }
+    }
+
+    static const char* integratorKeyword(Integrator integrator) {
+        switch (integrator) {
+        case Integrator::Leapfrog:
+            return "leapfrog";
+        case Integrator::Yoshida4:
+            return "yoshida4";
+        case Integrator::AdaptiveBlock:
+            return "adaptive";
+        default:
+            return "euler";
+        }
+    }
+
+    SceneDescription loadScene(const std::string& filepath) {
+        std::ifstream file{ filepath };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open scene: " + filepath);
+        }
+        return parseScene(file, filepath);
+    }
+
+    SceneDescription parseScene(std::istream& in, const std::string& name) {
+        SceneDescription scene{};
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            std::istringstream words{ line };
+            std::string directive;
+            if (!(words >> directive)) continue;
+            const auto fail = [&](const std::string& what) {
+                return std::runtime_error(name + ":" + std::to_string(lineNumber) + ": " + what);
+            };
+
+            if (directive == "gravity") {
+                words >> scene.gravity;
+            }
+            else if (directive == "unit") {
+                words >> scene.unitScale;
+            }
+            else if (directive == "theta") {
+                words >> scene.openingAngle;
+            }
+            else if (directive == "order") {
+                words >> scene.multipoleOrder;
+            }
+            else if (directive == "dt") {
+                words >> scene.frameDelta;
+            }
+            else if (directive == "substeps") {
+                words >> scene.substeps;
+            }
+            else if (directive == "solver" || directive == "integrator" || directive == "precision") {
+                std::string value;
+                words >> value;
+                if (directive == "solver" && value == "direct") scene.solver = GravitySolver::DirectSum;
+                else if (directive == "solver" && value == "barnes-hut") scene.solver = GravitySolver::BarnesHut;
+                else if (directive == "solver" && value == "fmm") scene.solver = GravitySolver::FastMultipole;
+                else if (directive == "integrator" && value == "euler") scene.integrator = Integrator::SemiImplicitEuler;
+                else if (directive == "integrator" && value == "leapfrog") scene.integrator = Integrator::Leapfrog;
+                else if (directive == "integrator" && value == "yoshida4") scene.integrator = Integrator::Yoshida4;
+                else if (directive == "integrator" && value == "adaptive") scene.integrator = Integrator::AdaptiveBlock;
+                else if (directive == "precision" && value == "single") scene.precision = Precision::Single;
+                else if (directive == "precision" && value == "double") scene.precision = Precision::Double;
+                else if (directive == "precision" && value == "mixed") scene.precision = Precision::Mixed;
+                else throw fail("unknown " + directive + " '" + value + "'");
+            }
+            else if (directive == "body") {
+                float px, py, pz, vx, vy, vz, mass, radius;
+                words >> px >> py >> pz >> vx >> vy >> vz >> mass >> radius;
+                if (words.fail()) throw fail("body needs x y z vx vy vz mass radius");
+                float r = 1.0f, g = 1.0f, b = 1.0f;
+                if (words >> r) {
+                    words >> g >> b;
+                    if (words.fail()) throw fail("body color needs r g b");
+                }
+                scene.bodies.add(static_cast<BodyStore::id_t>(scene.bodies.size()), px, py, pz, vx, vy, vz, mass,
+                    radius, r, g, b);
+                continue;
+            }
+            else if (directive == "disc") {
+                size_t count = 0;
+                uint32_t seed = 1;
+                words >> count;
+                if (words.fail()) throw fail("disc needs a body count");
+                words >> seed;
+                const BodyStore disc = makeRandomScene(count, seed);
+                scene.bodies.reserve(scene.bodies.size() + disc.size());
+                for (size_t i = 0; i < disc.size(); i++) {
+                    scene.bodies.add(static_cast<BodyStore::id_t>(scene.bodies.size()), disc.x[i], disc.y[i],
+                        disc.z[i], disc.vx[i], disc.vy[i], disc.vz[i], disc.mass[i], disc.radius[i], disc.colorR[i],
+                        disc.colorG[i], disc.colorB[i]);
+                }
+                continue;
+            }
+            else {
+                throw fail("unknown directive '" + directive + "'");
+            }
+
+            if (words.fail()) throw fail("missing value for " + directive);
+        }
+
+        if (scene.substeps == 0) {
+            throw std::runtime_error(name + ": substeps must be at least 1");
+        }
+        return scene;
+    }
+
+    void saveScene(const SceneDescription& scene, const std::string& filepath) {
+        std::ofstream file{ filepath };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to write scene: " + filepath);
+        }
+        writeScene(scene, file);
+    }
+
+    void writeScene(const SceneDescription& scene, std::ostream& out) {
+        // enough digits to read every float back unchanged
+        out << std::setprecision(std::numeric_limits<float>::max_digits10);
+        out << "gravity " << scene.gravity << "\n";
+        out << "unit " << scene.unitScale << "\n";
+        out << "solver " << solverKeyword(scene.solver) << "\n";
+        out << "theta " << scene.openingAngle << "\n";
+        out << "order " << scene.multipoleOrder << "\n";
+        out << "integrator " << integratorKeyword(scene.integrator) << "\n";
+        out << "precision " << precisionName(scene.precision) << "\n";
+        out << "dt " << scene.frameDelta << "\n";
+        out << "substeps " << scene.substeps << "\n";
+
+        const BodyStore& bodies = scene.bodies;
+        for (size_t i = 0; i < bodies.size(); i++) {
+            out << "body " << bodies.x[i] << " " << bodies.y[i] << " " << bodies.z[i] << " " << bodies.vx[i] << " "
+                << bodies.vy[i] << " " << bodies.vz[i] << " " << bodies.mass[i] << " " << bodies.radius[i] << " "
+                << bodies.colorR[i] << " " << bodies.colorG[i] << " " << bodies.colorB[i] << "\n";
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "body_store.hpp"
+#include "physics_system.hpp"
+
+// std
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace lve {
+    // Plain text scene for headless runs, one directive per line and '#' starting a comment:
+    //
+    //   gravity 1                    unit 1
+    //   solver direct|barnes-hut|fmm theta 0.5      order 4
+    //   integrator euler|leapfrog|yoshida4|adaptive
+    //   precision single|double|mixed
+    //   dt 0.0000833333              substeps 5
+    //   body x y z vx vy vz mass radius [r g b]
+    //   disc count [seed]            the random disc of the physics benchmarks
+    //
+    // Bodies get ids in the order they are listed. Anything not given keeps the defaults below,
+    // which match FirstApp.
+    struct SceneDescription {
+        float gravity{ 1.0f };
+        float unitScale{ 1.0f };
+        GravitySolver solver{ GravitySolver::DirectSum };
+        float openingAngle{ 0.5f };
+        int multipoleOrder{ 4 };
+        Integrator integrator{ Integrator::SemiImplicitEuler };
+        Precision precision{ Precision::Single };
+        float frameDelta{ (1.0f / 60) * 0.005f };  // seconds per update(), FirstApp's 60th of a second times its speedUp
+        unsigned int substeps{ 5 };
+        BodyStore bodies{};
+
+        // copies the solver, integrator and precision settings
+        void configure(PhysicsSystem& physics) const;
+    };
+
+    // Both throw std::runtime_error naming the line that could not be read.
+    SceneDescription loadScene(const std::string& filepath);
+    SceneDescription parseScene(std::istream& in, const std::string& name);
+
+    // Writes the scene back in the same format, with the bodies' current state.
+    void saveScene(const SceneDescription& scene, const std::string& filepath);
+    void writeScene(const SceneDescription& scene, std::ostream& out);
+}  // namespace lve
@@ -1,5 +1,9 @@
 #include "simple_render_system.hpp"
 
+#include "gpu_cull_system.hpp"
+#include "lve_swap_chain.hpp"
+#include "model.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -7,39 +11,74 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <limits>
 #include <stdexcept>
 
 namespace lve {
 
-    struct SimplePushConstantData {
-        glm::mat4 transform{ 1.f };
-        alignas(16) glm::vec3 color;
+    // Per-object data of simple_shader.vert, 64 bytes instead of the 80 of a mat4 and a color: the
+    // model matrix only needs the rows of its upper 3x4, the last one is always 0, 0, 0, 1.
+    struct SimpleObjectData {
+        glm::vec4 modelRows[3];
+        glm::vec4 color;
     };
 
-    SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass)
-        : lveDevice{ device } {
-        createPipelineLayout();
-        createPipeline(renderPass);
+    SimpleRenderSystem::SimpleRenderSystem(
+        LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
+        : lveDevice{ device },
+        instanceBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT),
+        objectBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT),
+        objectDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE) {
+        createObjectDescriptors();
+        createPipelineLayout(globalSetLayout);
+        // each creator fills a member of its own
+        LvePipeline::createInParallel({
+            [&] { createPipeline(renderPass); },
+            [&] {
+                instancedPipeline = createInstancedPipeline(
+                    renderPass, "../simple_shader_instanced.vert.spv", "../simple_shader.frag.spv");
+            },
+            // without the largePoints feature only a point size of 1 is guaranteed, which is all a
+            // sub-pixel body needs
+            [&] {
+                pointPipeline = createInstancedPipeline(
+                    renderPass, "../point_sprite.vert.spv", "../simple_shader.frag.spv", VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+            },
+            [&] { impostorPipeline = createInstancedPipeline(renderPass, "../impostor.vert.spv", "../impostor.frag.spv"); } });
+        createCircleLods();
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
         vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
     }
 
-    void SimpleRenderSystem::createPipelineLayout() {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
+    void SimpleRenderSystem::createObjectDescriptors() {
+        const uint32_t frameCount = LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+        objectPool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(frameCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount)
+            .build();
+        objectSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+    }
+
+    // Both pipelines share the layout: set 0 is the global ubo, set 1 the object buffer, which only
+    // the per-object pipeline reads.
+    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+            globalSetLayout, objectSetLayout->getDescriptorSetLayout() };
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 0;
-        pipelineLayoutInfo.pSetLayouts = nullptr;
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
@@ -61,29 +100,382 @@ namespace lve {
             pipelineConfig);
     }
 
-    void SimpleRenderSystem::renderGameObjects(
-		VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera& camera) {
-        lvePipeline->bind(commandBuffer);
-		
-        auto projectionView = camera.getProjection() * camera.getView();
+    // Same layout as the per-object pipeline, with the model matrix and color coming from the
+    // instance buffer instead of the object buffer. The mesh, point and impostor pipelines differ only
+    // in their shaders and topology.
+    std::unique_ptr<LvePipeline> SimpleRenderSystem::createInstancedPipeline(
+        VkRenderPass renderPass,
+        const std::string& vertFilepath,
+        const std::string& fragFilepath,
+        VkPrimitiveTopology topology) {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        PipelineConfigInfo pipelineConfig{};
+        LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.inputAssemblyInfo.topology = topology;
+        auto instanceBindings = InstanceData::getBindingDescriptions();
+        auto instanceAttributes = InstanceData::getAttributeDescriptions();
+        pipelineConfig.bindingDescriptions.insert(
+            pipelineConfig.bindingDescriptions.end(), instanceBindings.begin(), instanceBindings.end());
+        pipelineConfig.attributeDescriptions.insert(
+            pipelineConfig.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        return std::make_unique<LvePipeline>(lveDevice, vertFilepath, fragFilepath, pipelineConfig);
+    }
+
+    void SimpleRenderSystem::createCircleLods() {
+        for (unsigned int sides : CIRCLE_LOD_SIDES) {
+            // an edge strays r * (1 - cos(pi / n)) ~ r * pi^2 / (2 n^2) from the circle
+            const float ratio = sides / glm::pi<float>();
+            circleLods.push_back({ Model::createCircleModel(lveDevice, sides), 2.f * MAX_EDGE_ERROR * ratio * ratio });
+        }
+
+        LveModel::Builder builder{};
+        builder.vertices.push_back({});
+        pointModel = std::make_shared<LveModel>(lveDevice, builder);
+        // the corners at -1 and 1 are scaled by the radius in impostor.vert
+        impostorModel = Model::createRectangleModel(lveDevice, glm::vec3{ 1.f });
+    }
+
+    float SimpleRenderSystem::projectedRadius(
+        const LveCamera& camera, float viewportHeight, glm::vec3 position, float radius) {
+        const glm::vec4 viewPosition = camera.getView() * glm::vec4(position, 1.f);
+        const glm::mat4& projection = camera.getProjection();
+        // clip space w: the view depth for a perspective projection, 1 for an orthographic one
+        const float w = projection[2][3] * viewPosition.z + projection[3][3];
+        if (w <= 0.f) {
+            return std::numeric_limits<float>::infinity();
+        }
+        return radius * glm::abs(projection[1][1]) * 0.5f * viewportHeight / w;
+    }
+
+    void SimpleRenderSystem::selectCircleLods(
+        const LveCamera& camera, float viewportHeight, std::vector<LveGameObject>& objects) {
+        for (auto& obj : objects) {
+            if (obj.model == nullptr) continue;
+            const float radius = glm::max(glm::abs(obj.transform.scale.x), glm::abs(obj.transform.scale.y));
+            const float pixelRadius = projectedRadius(camera, viewportHeight, obj.transform.translation, radius);
+
+            const std::shared_ptr<LveModel>* model = &pointModel;
+            if (pixelRadius >= POINT_SPRITE_RADIUS && impostorBodies) {
+                model = &impostorModel;
+            }
+            else if (pixelRadius >= POINT_SPRITE_RADIUS) {
+                auto lod = std::find_if(circleLods.begin(), circleLods.end() - 1, [&](const CircleLod& level) {
+                    return pixelRadius <= level.maxPixelRadius;
+                });
+                model = &lod->model;
+            }
+            // most bodies keep their level from one frame to the next
+            if (obj.model != *model) {
+                obj.model = *model;
+            }
+        }
+    }
 
-		//render text
-		
+    std::vector<VkVertexInputBindingDescription> SimpleRenderSystem::InstanceData::getBindingDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 1;
+        bindingDescriptions[0].stride = sizeof(InstanceData);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> SimpleRenderSystem::InstanceData::getAttributeDescriptions() {
+        // a mat4 attribute takes one location per column
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+        for (uint32_t column = 0; column < 4; column++) {
+            attributeDescriptions[column].binding = 1;
+            attributeDescriptions[column].location = 2 + column;
+            attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attributeDescriptions[column].offset =
+                static_cast<uint32_t>(offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4));
+        }
+
+        attributeDescriptions[4].binding = 1;
+        attributeDescriptions[4].location = 6;
+        attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[4].offset = offsetof(InstanceData, color);
+        return attributeDescriptions;
+    }
+
+    // The buffer of a frame index is only reused after beginFrame waited on that frame's fence, so
+    // growing it can simply drop the old one.
+    void SimpleRenderSystem::reserveInstances(int frameIndex, uint32_t instanceCount) {
+        auto& instanceBuffer = instanceBuffers[frameIndex];
+        if (instanceBuffer != nullptr && instanceBuffer->getInstanceCount() >= instanceCount) {
+            return;
+        }
+
+        uint32_t capacity = instanceBuffer != nullptr ? instanceBuffer->getInstanceCount() * 2 : 256;
+        capacity = std::max(capacity, instanceCount);
+        instanceBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            sizeof(InstanceData),
+            capacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (instanceBuffer->map() != VK_SUCCESS) {
+            throw std::runtime_error("failed to map instance buffer!");
+        }
+    }
 
+    // Same as reserveInstances, but the descriptor set of the frame has to follow the buffer.
+    void SimpleRenderSystem::reserveObjects(int frameIndex, uint32_t objectCount) {
+        auto& objectBuffer = objectBuffers[frameIndex];
+        if (objectBuffer != nullptr && objectBuffer->getInstanceCount() >= objectCount) {
+            return;
+        }
+
+        uint32_t capacity = objectBuffer != nullptr ? objectBuffer->getInstanceCount() * 2 : 256;
+        capacity = std::max(capacity, objectCount);
+        objectBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            sizeof(SimpleObjectData),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (objectBuffer->map() != VK_SUCCESS) {
+            throw std::runtime_error("failed to map object buffer!");
+        }
+
+        auto bufferInfo = objectBuffer->descriptorInfo();
+        LveDescriptorWriter writer{ *objectSetLayout, *objectPool };
+        writer.writeBuffer(0, &bufferInfo);
+        if (objectDescriptorSets[frameIndex] == VK_NULL_HANDLE) {
+            if (!writer.build(objectDescriptorSets[frameIndex])) {
+                throw std::runtime_error("failed to allocate object descriptor set!");
+            }
+        }
+        else {
+            writer.overwrite(objectDescriptorSets[frameIndex]);
+        }
+    }
+
+    // There are only a handful of models and neighbouring objects mostly share one, so a linear
+    // search starting at the last hit beats hashing.
+    static SimpleRenderSystem::InstanceGroup& findGroup(
+        std::vector<SimpleRenderSystem::InstanceGroup>& groups, LveModel* model, size_t& lastGroup) {
+        if (lastGroup < groups.size() && groups[lastGroup].model == model) {
+            return groups[lastGroup];
+        }
+        for (lastGroup = 0; lastGroup < groups.size(); lastGroup++) {
+            if (groups[lastGroup].model == model) return groups[lastGroup];
+        }
+        groups.push_back({ model, 0, 0 });
+        return groups.back();
+    }
+
+    uint32_t SimpleRenderSystem::groupInstances(
+        const std::vector<std::vector<LveGameObject>*>& objectLists, std::vector<InstanceGroup>& groups) {
+        groups.clear();
+        size_t lastGroup = 0;
+        uint32_t instanceCount = 0;
+        for (auto* objects : objectLists) {
+            for (auto& obj : *objects) {
+                if (obj.model == nullptr) continue;
+                findGroup(groups, obj.model.get(), lastGroup).instanceCount++;
+                instanceCount++;
+            }
+        }
+
+        uint32_t firstInstance = 0;
+        for (auto& group : groups) {
+            group.firstInstance = firstInstance;
+            firstInstance += group.instanceCount;
+        }
+        return instanceCount;
+    }
+
+    void SimpleRenderSystem::writeInstances(
+        const std::vector<std::vector<LveGameObject>*>& objectLists,
+        std::vector<InstanceGroup>& groups,
+        InstanceData* instances) {
+        for (auto& group : groups) {
+            group.instanceCount = 0;
+        }
+
+        size_t lastGroup = 0;
+        for (auto* objects : objectLists) {
+            for (auto& obj : *objects) {
+                if (obj.model == nullptr) continue;
+                InstanceGroup& group = findGroup(groups, obj.model.get(), lastGroup);
+                InstanceData& instance = instances[group.firstInstance + group.instanceCount++];
+                instance.modelMatrix = obj.transform.mat4();
+                instance.color = glm::vec4(obj.color, 1.f);
+            }
+        }
+    }
+
+    void SimpleRenderSystem::bindInstancedPipeline(FrameInfo& frameInfo) {
+        instancedPipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &frameInfo.globalDescriptorSet,
+            0,
+            nullptr);
+    }
+
+    LvePipeline* SimpleRenderSystem::bindPipelineFor(
+        VkCommandBuffer commandBuffer, const LveModel* model, LvePipeline* bound) {
+        LvePipeline* pipeline = instancedPipeline.get();
+        if (model == pointModel.get()) {
+            pipeline = pointPipeline.get();
+        }
+        else if (model == impostorModel.get()) {
+            pipeline = impostorPipeline.get();
+        }
+        // all of them share the pipeline layout, so the global set stays bound
+        if (pipeline != bound) {
+            pipeline->bind(commandBuffer);
+        }
+        return pipeline;
+    }
+
+    void SimpleRenderSystem::renderGameObjectsInstanced(
+        FrameInfo& frameInfo, const std::vector<std::vector<LveGameObject>*>& objectLists) {
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        const int frameIndex = frameInfo.frameIndex;
+        // counting first gives every model one contiguous range of instances
+        const uint32_t instanceCount = groupInstances(objectLists, instanceGroups);
+        if (instanceCount == 0) return;
+
+        reserveInstances(frameIndex, instanceCount);
+        writeInstances(
+            objectLists,
+            instanceGroups,
+            static_cast<InstanceData*>(instanceBuffers[frameIndex]->getMappedMemory()));
+
+        bindInstancedPipeline(frameInfo);
+
+        VkBuffer buffers[] = { instanceBuffers[frameIndex]->getBuffer() };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+
+        LvePipeline* boundPipeline = instancedPipeline.get();
+        for (auto& group : instanceGroups) {
+            boundPipeline = bindPipelineFor(commandBuffer, group.model, boundPipeline);
+            group.model->bind(commandBuffer);
+            group.model->draw(commandBuffer, group.instanceCount, group.firstInstance);
+        }
+    }
+
+    void SimpleRenderSystem::renderCulledGameObjects(FrameInfo& frameInfo, const GpuCullSystem& cullSystem) {
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        const int frameIndex = frameInfo.frameIndex;
+        const auto& draws = cullSystem.getDraws(frameIndex);
+        if (draws.empty()) return;
+
+        bindInstancedPipeline(frameInfo);
+
+        // The indirect commands all start at instance 0, so each draw binds the visible buffer at
+        // the start of its own range instead of needing the drawIndirectFirstInstance feature.
+        VkBuffer buffers[] = { cullSystem.getVisibleBuffer(frameIndex) };
+        LvePipeline* boundPipeline = instancedPipeline.get();
+        for (size_t i = 0; i < draws.size(); i++) {
+            boundPipeline = bindPipelineFor(commandBuffer, draws[i].model, boundPipeline);
+            VkDeviceSize offsets[] = { draws[i].firstInstance * sizeof(InstanceData) };
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+            draws[i].model->bind(commandBuffer);
+            if (draws[i].model->hasIndexBuffer()) {
+                vkCmdDrawIndexedIndirect(
+                    commandBuffer,
+                    cullSystem.getDrawBuffer(frameIndex),
+                    i * sizeof(GpuCullSystem::DrawCommand),
+                    1,
+                    sizeof(GpuCullSystem::DrawCommand));
+            }
+            else {
+                vkCmdDrawIndirect(
+                    commandBuffer,
+                    cullSystem.getDrawBuffer(frameIndex),
+                    i * sizeof(GpuCullSystem::DrawCommand),
+                    1,
+                    sizeof(GpuCullSystem::DrawCommand));
+            }
+        }
+    }
+
+    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects) {
+        flatObjects.clear();
         for (auto& obj : gameObjects) {
-            SimplePushConstantData push{};
-            push.color = obj.color;
-            push.transform = projectionView * obj.transform.mat4();
-
-            vkCmdPushConstants(
-                commandBuffer,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(SimplePushConstantData),
-                &push);
-            obj.model->bind(commandBuffer);
-            obj.model->draw(commandBuffer);
+            flatObjects.push_back(&obj);
+        }
+        if (flatObjects.empty()) return;
+
+        reserveObjects(frameInfo.frameIndex, static_cast<uint32_t>(flatObjects.size()));
+        recordObjects(frameInfo.commandBuffer, frameInfo, 0, flatObjects.size());
+    }
+
+    void SimpleRenderSystem::renderGameObjectsParallel(
+        FrameInfo& frameInfo,
+        const std::vector<std::vector<LveGameObject>*>& objectLists,
+        LveSecondaryRecorder& recorder,
+        VkRenderPass renderPass,
+        VkFramebuffer framebuffer,
+        VkExtent2D extent) {
+        flatObjects.clear();
+        for (auto* objects : objectLists) {
+            for (auto& obj : *objects) {
+                flatObjects.push_back(&obj);
+            }
+        }
+        if (flatObjects.empty()) return;
+
+        reserveObjects(frameInfo.frameIndex, static_cast<uint32_t>(flatObjects.size()));
+        recorder.record(
+            frameInfo.commandBuffer,
+            frameInfo.frameIndex,
+            renderPass,
+            framebuffer,
+            extent,
+            flatObjects.size(),
+            [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+                recordObjects(commandBuffer, frameInfo, begin, end);
+            });
+    }
+
+    // Called from several threads at once by renderGameObjectsParallel, each with its own command
+    // buffer and range, so it only reads shared state and writes the objects of its range.
+    void SimpleRenderSystem::recordObjects(
+        VkCommandBuffer commandBuffer, const FrameInfo& frameInfo, size_t begin, size_t end) {
+        auto* objects = static_cast<SimpleObjectData*>(objectBuffers[frameInfo.frameIndex]->getMappedMemory());
+        for (size_t i = begin; i < end; i++) {
+            auto& obj = *flatObjects[i];
+            const glm::mat4 modelMatrix = obj.transform.mat4();
+            for (int row = 0; row < 3; row++) {
+                objects[i].modelRows[row] = { modelMatrix[0][row], modelMatrix[1][row], modelMatrix[2][row], modelMatrix[3][row] };
+            }
+            objects[i].color = glm::vec4(obj.color, 1.f);
+        }
+
+        lvePipeline->bind(commandBuffer);
+        VkDescriptorSet descriptorSets[] = { frameInfo.globalDescriptorSet, objectDescriptorSets[frameInfo.frameIndex] };
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            2,
+            descriptorSets,
+            0,
+            nullptr);
+
+        // the shader finds the object at gl_InstanceIndex, which starts at firstInstance
+        LveModel* boundModel = nullptr;
+        for (size_t i = begin; i < end; i++) {
+            LveModel* model = flatObjects[i]->model.get();
+            if (model == nullptr) continue;
+            if (model != boundModel) {
+                model->bind(commandBuffer);
+                boundModel = model;
+            }
+            model->draw(commandBuffer, 1, static_cast<uint32_t>(i));
         }
     }
 
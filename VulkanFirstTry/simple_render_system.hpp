@@ -1,32 +1,150 @@
 #pragma once
 
+#include "lve_buffer.hpp"
+#include "lve_descriptors.hpp"
 #include "lve_device.hpp"
+#include "lve_frame_info.hpp"
 #include "lve_game_object.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_secondary_recorder.hpp"
 #include "lve_camera.hpp"
 
 // std
+#include <array>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve {
+	class GpuCullSystem;
+
 	class SimpleRenderSystem {
 	public:
-		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass);
+		// globalSetLayout describes set 0, the GlobalUbo of FrameInfo::globalDescriptorSet
+		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
-		void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera& camera);
+		// per-instance vertex data of the instanced pipeline, read from binding 1
+		struct InstanceData {
+			glm::mat4 modelMatrix{ 1.f };
+			glm::vec4 color{};
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		// the instances of one model, contiguous in an instance buffer
+		struct InstanceGroup {
+			LveModel* model;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
+
+		// Groups the objects of all lists by model, giving each group its range of instances, and
+		// returns the total.
+		static uint32_t groupInstances(
+			const std::vector<std::vector<LveGameObject>*>& objectLists, std::vector<InstanceGroup>& groups);
+		// writes the instances of the groups made by groupInstances from the same lists
+		static void writeInstances(
+			const std::vector<std::vector<LveGameObject>*>& objectLists,
+			std::vector<InstanceGroup>& groups,
+			InstanceData* instances);
+
+		// Circle meshes from coarse to fine. A side count is good up to the projected radius at which
+		// its edges stray MAX_EDGE_ERROR pixels from the true circle.
+		static constexpr std::array<unsigned int, 5> CIRCLE_LOD_SIDES{ 8, 16, 32, 64, 128 };
+		static constexpr float MAX_EDGE_ERROR = 0.5f;
+		// bodies with a smaller projected radius cover less than a pixel and are drawn as one point
+		static constexpr float POINT_SPRITE_RADIUS = 0.5f;
+
+		// Radius in pixels of a sphere at position with the given world space radius, viewportHeight
+		// pixels tall, for perspective and orthographic cameras alike. Infinite at or behind the eye.
+		static float projectedRadius(const LveCamera& camera, float viewportHeight, glm::vec3 position, float radius);
+
+		// Gives every object the circle mesh, or the point, matching its projected size, taking the
+		// radius from its scale. Meant for the unit circle bodies before they are culled and drawn.
+		// With impostorBodies every body above point size gets the impostor quad instead.
+		void selectCircleLods(const LveCamera& camera, float viewportHeight, std::vector<LveGameObject>& objects);
+		const std::shared_ptr<LveModel>& getPointModel() const { return pointModel; }
+		const std::shared_ptr<LveModel>& getImpostorModel() const { return impostorModel; }
+
+		// Draw bodies as one camera facing quad each, which impostor.frag turns into a shaded sphere by
+		// intersecting the eye ray with it, depth included. 4 vertices instead of the 129 of the
+		// finest circle, at the price of a fragment shader that writes depth.
+		bool impostorBodies = false;
+
+		// Draws the objects one by one. Their model matrices and colors are written in one pass to the
+		// storage buffer of the frame, which the shader indexes with the instance index.
+		void renderGameObjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects);
+
+		// Same as renderGameObjects for all lists, with the objects split into chunks written and
+		// recorded in parallel by recorder. Must come inside subpass 0 of renderPass, begun with
+		// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS; the per-object pipeline has no point or
+		// impostor path, so the objects should keep their meshes.
+		void renderGameObjectsParallel(
+			FrameInfo& frameInfo,
+			const std::vector<std::vector<LveGameObject>*>& objectLists,
+			LveSecondaryRecorder& recorder,
+			VkRenderPass renderPass,
+			VkFramebuffer framebuffer,
+			VkExtent2D extent);
+
+		// Draws the objects of all lists with one vkCmdDraw per distinct model. Their transforms and
+		// colors go to the instance buffer of frameIndex, so everything drawn instanced in a frame has
+		// to come in a single call.
+		void renderGameObjectsInstanced(
+			FrameInfo& frameInfo, const std::vector<std::vector<LveGameObject>*>& objectLists);
+
+		// Draws what cullSystem.cull() left visible in this frame with vkCmdDrawIndirect, one per
+		// model. Must come after the cull in the same command buffer.
+		void renderCulledGameObjects(FrameInfo& frameInfo, const GpuCullSystem& cullSystem);
 
 	private:
-		void createPipelineLayout();
+		void createObjectDescriptors();
+		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
+		std::unique_ptr<LvePipeline> createInstancedPipeline(
+			VkRenderPass renderPass,
+			const std::string& vertFilepath,
+			const std::string& fragFilepath,
+			VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+		void reserveInstances(int frameIndex, uint32_t instanceCount);
+		void reserveObjects(int frameIndex, uint32_t objectCount);
+		void createCircleLods();
+		void bindInstancedPipeline(FrameInfo& frameInfo);
+		// writes the objects [begin, end) of flatObjects and records their draws
+		void recordObjects(VkCommandBuffer commandBuffer, const FrameInfo& frameInfo, size_t begin, size_t end);
+		// switches between the instanced, point and impostor pipelines for the model, returns the bound one
+		LvePipeline* bindPipelineFor(VkCommandBuffer commandBuffer, const LveModel* model, LvePipeline* bound);
 
 		LveDevice& lveDevice;
 
 		std::unique_ptr<LvePipeline> lvePipeline;
+		std::unique_ptr<LvePipeline> instancedPipeline;
+		std::unique_ptr<LvePipeline> pointPipeline;  // instanced as well, one vertex per instance
+		std::unique_ptr<LvePipeline> impostorPipeline;
 		VkPipelineLayout pipelineLayout;
+
+		// one persistently mapped buffer per frame in flight, grown on demand
+		std::vector<std::unique_ptr<LveBuffer>> instanceBuffers;
+		std::vector<InstanceGroup> instanceGroups;
+
+		struct CircleLod {
+			std::shared_ptr<LveModel> model;
+			float maxPixelRadius;
+		};
+		std::vector<CircleLod> circleLods;
+		std::shared_ptr<LveModel> pointModel;
+		std::shared_ptr<LveModel> impostorModel;
+
+		// set 1 of the per-object pipeline, likewise one per frame in flight
+		std::unique_ptr<LveDescriptorPool> objectPool;
+		std::unique_ptr<LveDescriptorSetLayout> objectSetLayout;
+		std::vector<std::unique_ptr<LveBuffer>> objectBuffers;
+		std::vector<VkDescriptorSet> objectDescriptorSets;
+		std::vector<LveGameObject*> flatObjects;  // the objects being drawn, in object buffer order
 	};
 }  // namespace lve
\ No newline at end of file
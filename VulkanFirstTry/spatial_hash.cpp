@@ -0,0 +1,119 @@
+#include "spatial_hash.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace lve {
+
+    void SpatialHash::build(const float* x, const float* y, const float* z, const float* radius, size_t count) {
+        inX = x;
+        inY = y;
+        inZ = z;
+        inRadius = radius;
+        bodyCount = count;
+        largeBodies.clear();
+        if (count == 0) {
+            bucketMask = 0;
+            bucketStart.assign(2, 0);
+            bucketBodies.clear();
+            return;
+        }
+
+        // two regular radii fit in one cell, so an overlapping pair is never more than a cell apart;
+        // a handful of stars must not blow the cells up to their size
+        scratch.assign(radius, radius + count);
+        const size_t nth = std::min(count - 1, count * 95 / 100);
+        std::nth_element(scratch.begin(), scratch.begin() + nth, scratch.end());
+        const float maxRadius = *std::max_element(scratch.begin() + nth, scratch.end());
+        largeRadius = std::min(maxRadius, LARGE_RADIUS_FACTOR * scratch[nth]);
+        cellSize = largeRadius > 0.0f ? 2.0f * largeRadius : 1.0f;
+
+        // power of two table with about two buckets per body
+        size_t buckets = 1;
+        while (buckets < 2 * count) buckets <<= 1;
+        bucketMask = buckets - 1;
+
+        bucketStart.assign(buckets + 1, 0);
+        for (uint32_t i = 0; i < count; i++) {
+            if (radius[i] > largeRadius) {
+                largeBodies.push_back(i);
+                continue;
+            }
+            bucketStart[bucketOf(cellOf(i)) + 1]++;
+        }
+        for (size_t b = 0; b < buckets; b++) {
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        bucketBodies.resize(bucketStart[buckets]);
+        std::vector<uint32_t> cursor(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t i = 0; i < count; i++) {
+            if (radius[i] > largeRadius) continue;
+            bucketBodies[cursor[bucketOf(cellOf(i))]++] = i;
+        }
+    }
+
+    SpatialHash::Cell SpatialHash::cellOf(uint32_t body) const {
+        const float inverse = 1.0f / cellSize;
+        return {
+            static_cast<int32_t>(std::floor(inX[body] * inverse)),
+            static_cast<int32_t>(std::floor(inY[body] * inverse)),
+            static_cast<int32_t>(std::floor(inZ[body] * inverse)) };
+    }
+
+    size_t SpatialHash::bucketOf(const Cell& cell) const {
+        // Teschner et al. prime hashing
+        const uint32_t h = (static_cast<uint32_t>(cell.x) * 73856093u) ^
+            (static_cast<uint32_t>(cell.y) * 19349663u) ^ (static_cast<uint32_t>(cell.z) * 83492791u);
+        return h & bucketMask;
+    }
+
+    bool SpatialHash::overlaps(uint32_t a, uint32_t b) const {
+        const float dx = inX[b] - inX[a];
+        const float dy = inY[b] - inY[a];
+        const float dz = inZ[b] - inZ[a];
+        const float r2 = dx * dx + dy * dy + dz * dz;
+        const float touch = inRadius[a] + inRadius[b];
+        return r2 < touch * touch || r2 == 0.0f;
+    }
+
+    void SpatialHash::overlapsOf(uint32_t i, std::vector<Pair>& out) const {
+        assert(i < bodyCount && "Body index out of range");
+
+        // large bodies are paired with everything after them, and regular ones with the large
+        // bodies after them, so every pair is reported exactly once from its lower index
+        if (inRadius[i] > largeRadius) {
+            for (uint32_t j = i + 1; j < bodyCount; j++) {
+                if (overlaps(i, j)) out.emplace_back(i, j);
+            }
+            return;
+        }
+        for (const uint32_t j : largeBodies) {
+            if (j > i && overlaps(i, j)) out.emplace_back(i, j);
+        }
+
+        // neighbouring cells can share a bucket, visit each bucket once
+        const Cell home = cellOf(i);
+        std::array<size_t, 27> buckets;
+        size_t bucketCount = 0;
+        for (int dz = -1; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    buckets[bucketCount++] = bucketOf({ home.x + dx, home.y + dy, home.z + dz });
+                }
+            }
+        }
+        std::sort(buckets.begin(), buckets.end());
+        const auto last = std::unique(buckets.begin(), buckets.end());
+
+        for (auto bucket = buckets.begin(); bucket != last; ++bucket) {
+            for (uint32_t k = bucketStart[*bucket]; k < bucketStart[*bucket + 1]; k++) {
+                const uint32_t j = bucketBodies[k];
+                if (j > i && overlaps(i, j)) out.emplace_back(i, j);
+            }
+        }
+    }
+
+}  // namespace lve
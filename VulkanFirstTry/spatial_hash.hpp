@@ -0,0 +1,60 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lve {
+    // Uniform grid broad phase for body overlaps. Cells are hashed into a table of buckets
+    // (collisions only cost extra candidates, the exact test filters them), and the cell size is
+    // picked from the body radii so two overlapping regular bodies are always in neighbouring cells.
+    // The few bodies larger than that are tested against everything instead of inflating the grid.
+    class SpatialHash {
+    public:
+        using Pair = std::pair<uint32_t, uint32_t>;
+
+        // radii up to this many times the 95th percentile still go into the grid
+        static constexpr float LARGE_RADIUS_FACTOR = 4.0f;
+
+        SpatialHash() = default;
+
+        SpatialHash(const SpatialHash&) = delete;
+        SpatialHash& operator=(const SpatialHash&) = delete;
+
+        // The arrays must stay alive and unchanged until the last overlapsOf() call.
+        void build(const float* x, const float* y, const float* z, const float* radius, size_t count);
+
+        // Appends every pair (i, j) with j > i whose distance is below the summed radii, or zero.
+        // Read-only, so disjoint ranges of i can be queried from different threads.
+        void overlapsOf(uint32_t i, std::vector<Pair>& out) const;
+
+        float getCellSize() const { return cellSize; }
+        size_t largeBodyCount() const { return largeBodies.size(); }
+
+    private:
+        struct Cell {
+            int32_t x, y, z;
+        };
+
+        Cell cellOf(uint32_t body) const;
+        size_t bucketOf(const Cell& cell) const;
+        bool overlaps(uint32_t a, uint32_t b) const;
+
+        float cellSize = 1.0f;
+        float largeRadius = 0.0f;  // bodies above this radius are not in the grid
+        size_t bucketMask = 0;
+
+        std::vector<uint32_t> bucketStart;  // bucketMask + 2 entries, counting sort offsets
+        std::vector<uint32_t> bucketBodies;
+        std::vector<uint32_t> largeBodies;
+        std::vector<float> scratch;
+
+        const float* inX = nullptr;
+        const float* inY = nullptr;
+        const float* inZ = nullptr;
+        const float* inRadius = nullptr;
+        size_t bodyCount = 0;
+    };
+}  // namespace lve
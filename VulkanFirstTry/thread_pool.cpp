@@ -0,0 +1,122 @@
+#include "thread_pool.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+    ThreadPool::ThreadPool(unsigned int threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        queues.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        // worker 0 is whichever thread calls parallelFor
+        workers.reserve(threadCount - 1);
+        for (unsigned int i = 1; i < threadCount; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{ stateMutex };
+            stopping = true;
+        }
+        wakeWorkers.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t count, size_t tileSize, const TileFunction& fn) {
+        if (count == 0) return;
+        tileSize = std::max<size_t>(tileSize, 1);
+        const size_t tileCount = (count + tileSize - 1) / tileSize;
+        if (workers.empty() || tileCount == 1) {
+            for (size_t begin = 0; begin < count; begin += tileSize) {
+                fn(begin, std::min(begin + tileSize, count));
+            }
+            return;
+        }
+
+        // the job has to be in place before the first tile becomes visible: a worker still
+        // draining the previous call may steal one as soon as it is queued
+        job = &fn;
+        jobCount = count;
+        jobTileSize = tileSize;
+        remainingTiles.store(tileCount);
+
+        // contiguous runs of tiles per worker, stealing evens out whatever is left over
+        const size_t threads = queues.size();
+        for (size_t w = 0; w < threads; w++) {
+            const size_t first = tileCount * w / threads;
+            const size_t last = tileCount * (w + 1) / threads;
+            std::lock_guard<std::mutex> lock{ queues[w]->mutex };
+            for (size_t tile = first; tile < last; tile++) {
+                queues[w]->tiles.push_back(tile);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock{ stateMutex };
+            generation++;
+        }
+        wakeWorkers.notify_all();
+
+        runTiles(0);
+
+        std::unique_lock<std::mutex> lock{ stateMutex };
+        jobFinished.wait(lock, [this] { return remainingTiles.load() == 0; });
+    }
+
+    void ThreadPool::workerLoop(unsigned int index) {
+        unsigned long long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock{ stateMutex };
+                wakeWorkers.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            runTiles(index);
+        }
+    }
+
+    void ThreadPool::runTiles(unsigned int index) {
+        size_t tile;
+        while (popLocal(index, tile) || steal(index, tile)) {
+            const size_t begin = tile * jobTileSize;
+            (*job)(begin, std::min(begin + jobTileSize, jobCount));
+            if (remainingTiles.fetch_sub(1) == 1) {
+                // taking the lock orders the notify after the waiter's predicate check
+                std::lock_guard<std::mutex> lock{ stateMutex };
+                jobFinished.notify_all();
+            }
+        }
+    }
+
+    bool ThreadPool::popLocal(unsigned int index, size_t& tile) {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        if (queue.tiles.empty()) return false;
+        tile = queue.tiles.front();
+        queue.tiles.pop_front();
+        return true;
+    }
+
+    bool ThreadPool::steal(unsigned int thief, size_t& tile) {
+        const size_t threads = queues.size();
+        for (size_t offset = 1; offset < threads; offset++) {
+            WorkerQueue& victim = *queues[(thief + offset) % threads];
+            std::lock_guard<std::mutex> lock{ victim.mutex };
+            if (victim.tiles.empty()) continue;
+            tile = victim.tiles.back();
+            victim.tiles.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+}  // namespace lve
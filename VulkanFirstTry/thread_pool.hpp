@@ -0,0 +1,62 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+    // Fixed-size pool for data-parallel loops. Each worker owns a deque of tiles; it pops from its
+    // own front and steals from the back of the others once it runs dry. The calling thread takes
+    // part as worker 0, so a pool of one thread runs everything inline.
+    class ThreadPool {
+    public:
+        using TileFunction = std::function<void(size_t begin, size_t end)>;
+
+        // 0 picks std::thread::hardware_concurrency()
+        explicit ThreadPool(unsigned int threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned int threadCount() const { return static_cast<unsigned int>(queues.size()); }
+
+        // Calls fn over [0, count) in tiles of tileSize and blocks until all tiles are done. The tile
+        // boundaries only depend on count and tileSize, never on the thread count, so anything
+        // computed per tile is identical however the tiles get scheduled.
+        void parallelFor(size_t count, size_t tileSize, const TileFunction& fn);
+
+    private:
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<size_t> tiles;
+        };
+
+        void workerLoop(unsigned int index);
+        void runTiles(unsigned int index);
+        bool popLocal(unsigned int index, size_t& tile);
+        bool steal(unsigned int thief, size_t& tile);
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::vector<std::thread> workers;
+
+        // current job, published to the workers through the queue mutexes
+        const TileFunction* job = nullptr;
+        size_t jobCount = 0;
+        size_t jobTileSize = 0;
+        std::atomic<size_t> remainingTiles{ 0 };
+
+        std::mutex stateMutex;
+        std::condition_variable wakeWorkers;
+        std::condition_variable jobFinished;
+        unsigned long long generation = 0;
+        bool stopping = false;
+    };
+}  // namespace lve
@@ -0,0 +1,48 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lve {
+    // Hands the latest value from one writer thread to one reader thread without locks or waiting.
+    //
+    // The writer fills the back slot and publishes it by swapping it with the middle one; the reader
+    // swaps the middle one with its front slot when it holds something newer. Neither side ever
+    // touches the other's slot, and values the reader is too slow for are simply overwritten. The
+    // slots are reused, so a value holding vectors stops allocating once they have grown.
+    template <typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // writer side: the slot to fill, still holding the value published three times ago
+        T& writeBuffer() { return slots[back]; }
+        void publish() {
+            back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // reader side: takes the newest published value if there is one, returns whether it did
+        bool update() {
+            if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+        // the value taken by the last update(), default constructed before the first one
+        const T& readBuffer() const { return slots[front]; }
+
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x3;
+        static constexpr uint8_t FRESH = 0x4;  // set while the middle slot has not been read
+
+        std::array<T, 3> slots{};
+        uint8_t back = 0;                  // writer only
+        std::atomic<uint8_t> middle{ 1 };  // index of the shared slot, plus FRESH
+        uint8_t front = 2;                 // reader only
+    };
+}  // namespace lve
@@ -1,3 +1,10 @@
 C:\VulkanSDK\1.3.224.1\Bin\glslc.exe simple_shader.vert -o simple_shader.vert.spv
 C:\VulkanSDK\1.3.224.1\Bin\glslc.exe simple_shader.frag -o simple_shader.frag.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe simple_shader_instanced.vert -o simple_shader_instanced.vert.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe cull_instances.comp -o cull_instances.comp.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe nbody_step.comp -o nbody_step.comp.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe nbody_shader.vert -o nbody_shader.vert.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe point_sprite.vert -o point_sprite.vert.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe impostor.vert -o impostor.vert.spv
+C:\VulkanSDK\1.3.224.1\Bin\glslc.exe impostor.frag -o impostor.frag.spv
 pause
\ No newline at end of file
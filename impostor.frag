@@ -0,0 +1,40 @@
+#version 450
+
+layout(location = 0) in vec3 fragViewPosition;
+layout(location = 1) flat in vec3 fragCenter;
+layout(location = 2) flat in float fragRadius;
+layout(location = 3) flat in vec3 fragColor;
+
+layout (location = 0) out vec4 outColor;
+// the sphere is never in front of its quad, which keeps early depth testing against the quad valid
+layout(depth_greater) out float gl_FragDepth;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projectionView;
+	mat4 projection;
+	mat4 view;
+} ubo;
+
+void main() {
+	// the eye ray through this fragment, in view space; an orthographic camera's rays run along +z
+	bool perspective = ubo.projection[3][3] == 0.0;
+	vec3 origin = perspective ? vec3(0.0) : vec3(fragViewPosition.xy, 0.0);
+	vec3 direction = perspective ? normalize(fragViewPosition) : vec3(0.0, 0.0, 1.0);
+
+	vec3 toCenter = fragCenter - origin;
+	float along = dot(toCenter, direction);
+	float missSquared = dot(toCenter, toCenter) - along * along;
+	float radiusSquared = fragRadius * fragRadius;
+	if (missSquared > radiusSquared) {
+		discard;
+	}
+
+	vec3 hit = origin + direction * (along - sqrt(radiusSquared - missSquared));
+	vec4 clipPosition = ubo.projection * vec4(hit, 1.0);
+	gl_FragDepth = clipPosition.z / clipPosition.w;
+
+	// lit from the eye, so the limb darkens like a sphere's
+	vec3 normal = (hit - fragCenter) / fragRadius;
+	float diffuse = max(dot(normal, -direction), 0.0);
+	outColor = vec4(fragColor * (0.25 + 0.75 * diffuse), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+// per instance, binding 1; the mat4 takes locations 2 to 5
+layout(location = 2) in mat4 modelMatrix;
+layout(location = 6) in vec4 instanceColor;
+
+layout(location = 0) out vec3 fragViewPosition;
+layout(location = 1) flat out vec3 fragCenter;
+layout(location = 2) flat out float fragRadius;
+layout(location = 3) flat out vec3 fragColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projectionView;
+	mat4 projection;
+	mat4 view;
+} ubo;
+
+void main(){
+	vec3 center = (ubo.view * vec4(modelMatrix[3].xyz, 1.0)).xyz;
+	float radius = max(length(modelMatrix[0].xyz), length(modelMatrix[1].xyz));
+
+	// A quad facing the camera with the sphere's radius, pulled one radius towards the eye, covers
+	// the sphere's outline from any point outside of it, and nothing of the sphere lies in front of it.
+	vec3 viewPosition = center + vec3(position.xy * radius, -radius);
+	gl_Position = ubo.projection * vec4(viewPosition, 1.0);
+
+	fragViewPosition = viewPosition;
+	fragCenter = center;
+	fragRadius = radius;
+	fragColor = instanceColor.rgb;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+// per instance, straight from the buffers of the n-body compute pass
+layout(location = 2) in vec4 body;        // xyz, mass
+layout(location = 3) in vec4 properties;  // color, radius
+
+layout(location=0) out vec3 fragColor;
+
+// transform is the projection-view only
+layout(push_constant) uniform Push {
+	mat4 transform;
+	vec3 color;
+} push;
+
+void main(){
+	gl_Position = push.transform * vec4(body.xyz + properties.w * position, 1.0);
+	fragColor = properties.rgb;
+}
@@ -5,12 +5,27 @@ layout(location = 1) in vec3 color;
 
 layout(location=0) out vec3 fragColor;
 
-layout(push_constant) uniform Push {
-	mat4 transform;
-	vec3 color;
-} push;
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projectionView;
+} ubo;
+
+// one per game object, written by the cpu each frame; the rows of the upper 3x4 of the model matrix
+struct ObjectData {
+	vec4 modelRows[3];
+	vec4 color;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Objects {
+	ObjectData objects[];
+};
 
 void main(){
-	gl_Position = push.transform * vec4(position, 1.0);
-	fragColor = push.color;
+	ObjectData object = objects[gl_InstanceIndex];
+	vec4 localPosition = vec4(position, 1.0);
+	vec3 worldPosition = vec3(
+		dot(object.modelRows[0], localPosition),
+		dot(object.modelRows[1], localPosition),
+		dot(object.modelRows[2], localPosition));
+	gl_Position = ubo.projectionView * vec4(worldPosition, 1.0);
+	fragColor = object.color.rgb;
 }
\ No newline at end of file
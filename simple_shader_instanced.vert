@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+// per instance, binding 1; the mat4 takes locations 2 to 5
+layout(location = 2) in mat4 modelMatrix;
+layout(location = 6) in vec4 instanceColor;
+
+layout(location=0) out vec3 fragColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projectionView;
+} ubo;
+
+void main(){
+	gl_Position = ubo.projectionView * modelMatrix * vec4(position, 1.0);
+	fragColor = instanceColor.rgb;
+}
\ No newline at end of file